@@ -25,12 +25,32 @@ typedef int CSIP_VARTYPE;
 #define CSIP_VARTYPE_IMPLINT 2
 #define CSIP_VARTYPE_CONTINUOUS 3
 
+/* types of special ordered sets */
+typedef int CSIP_SOSTYPE;
+#define CSIP_SOSTYPE_SOS1 1
+#define CSIP_SOSTYPE_SOS2 2
+
+/* types of orbitopes */
+typedef int CSIP_ORBITOPETYPE;
+#define CSIP_ORBITOPETYPE_PARTITIONING 1 // exactly one 1 per row
+#define CSIP_ORBITOPETYPE_PACKING 2      // at most one 1 per row
+
+/* bound types, for bound disjunctions */
+typedef int CSIP_BOUNDTYPE;
+#define CSIP_BOUNDTYPE_LOWER 0 // var >= bound
+#define CSIP_BOUNDTYPE_UPPER 1 // var <= bound
+
 /* solving context for lazy callbacks */
 typedef int CSIP_LAZY_CONTEXT;
 #define CSIP_LAZY_LPRELAX 0     // we have (fractional) LP relaxtion of B&B node
 #define CSIP_LAZY_INTEGRALSOL 1 // current candidate is integer feasible
 #define CSIP_LAZY_OTHER 2       // e.g., CHECK is called on fractional candidate
 
+/* types of callbacks, for time budgets */
+typedef int CSIP_CALLBACKTYPE;
+#define CSIP_CALLBACKTYPE_LAZY 0
+#define CSIP_CALLBACKTYPE_HEURISTIC 1
+
 /* nonlinear operators */
 typedef int CSIP_OP;
 #define VARIDX 1
@@ -44,6 +64,20 @@ typedef int CSIP_OP;
 #define SUM 64
 #define PROD 65
 
+/* curvature of nonlinear functions */
+typedef int CSIP_CURVATURE;
+#define CSIP_CURVATURE_UNKNOWN 0
+#define CSIP_CURVATURE_CONVEX 1
+#define CSIP_CURVATURE_CONCAVE 2
+
+/* what became of the initial solution in the last solve */
+typedef int CSIP_INITSOLSTATUS;
+#define CSIP_INITSOL_NONE 0       // no initial solution was given
+#define CSIP_INITSOL_PARTIAL 1    // partial solution, passed on for completion
+#define CSIP_INITSOL_FEASIBLE 2   // solution was feasible and added
+#define CSIP_INITSOL_REPAIRED 3   // solution was infeasible, repaired one added
+#define CSIP_INITSOL_INFEASIBLE 4 // solution was infeasible and discarded
+
 /* parameter types */
 typedef int CSIP_PARAMTYPE;
 #define CSIP_PARAMTYPE_NOTAPARAM -1
@@ -54,6 +88,74 @@ typedef int CSIP_PARAMTYPE;
 #define CSIP_PARAMTYPE_CHAR 4
 #define CSIP_PARAMTYPE_STRING 5
 
+/* running time statistics of a callback */
+typedef struct csip_callback_stats
+{
+    long long ncalls;
+    long long noverruns;  // calls that took longer than the time budget
+    double totaltime;     // wall clock seconds spent in the callback
+    double maxtime;       // longest call, in wall clock seconds
+    int flagged;          // whether the budget was overrun maxoverruns times
+} CSIP_CALLBACK_STATS;
+
+/* progress estimate of the branch-and-bound search */
+typedef struct csip_progress
+{
+    long long nnodes;     // number of processed nodes
+    double treeweight;    // explored fraction of the tree, in [0, 1]
+    double gapclosed;     // closed fraction of the first finite gap, in [0, 1]
+    double treesize;      // estimated final number of nodes, or -1 if unknown
+    double remainingtime; // estimated remaining seconds, or -1 if unknown
+} CSIP_PROGRESS;
+
+/* executor for the parallel work of CSIP, see CSIPsetExecutor */
+typedef void (*CSIP_JOB)(void *arg);
+typedef struct csip_executor
+{
+    // start job(arg), possibly on another thread; returns a handle for wait,
+    // or NULL if the job can not be started
+    void *(*submit)(void *executordata, CSIP_JOB job, void *arg);
+    // return once the job of handle has finished, and release the handle
+    void (*wait)(void *executordata, void *handle);
+    // number of jobs worth running at the same time, or 0 if unknown; may be
+    // NULL
+    int (*concurrency)(void *executordata);
+    void *executordata;
+} CSIP_EXECUTOR;
+
+/* sparse changes of a scenario, relative to a base model */
+typedef struct csip_scenario
+{
+    // new variable bounds; lowerbounds or upperbounds may be NULL
+    int nbounds;
+    int *boundindices;
+    double *lowerbounds;
+    double *upperbounds;
+
+    // new sides of linear constraints; lhs or rhs may be NULL
+    int nsides;
+    int *consindices;
+    double *lhs;
+    double *rhs;
+
+    // new linear objective coefficients
+    int nobj;
+    int *objindices;
+    double *objcoefs;
+} CSIP_SCENARIO;
+
+/* result of solving a scenario */
+typedef struct csip_scenario_result
+{
+    CSIP_STATUS status;
+    double objvalue;      // NaN if no solution was found
+    double objbound;
+    // best solution is copied here if not NULL (allocated by user)
+    double *values;
+    // CPU the scenario was solved on, or -1 if unknown
+    int cpu;
+} CSIP_SCENARIO_RESULT;
+
 // versioning scheme: major.minor.patch
 int CSIPmajorVersion();
 int CSIPminorVersion();
@@ -110,6 +212,24 @@ CSIP_RETCODE CSIPaddQuadCons(
     int numquadterms, int *quadrowindices, int *quadcolindices,
     double *quadcoefs, double lhs, double rhs, int *idx);
 
+// Add ncons quadratic constraints at once, of the form:
+//    lhs[c] <= sum_i lincoefs[i] * vars[linindices[i]]
+//              + sum_j quadcoefs[j] * vars[quadrowindices[j]]
+//                                   * vars[quadcolindices[j]] <= rhs[c]
+// The linear part of constraint c is given by the entries linbeg[c] until
+// linbeg[c+1]-1 of linindices and lincoefs. Quadratic term j belongs to
+// constraint quadconsindices[j], in any order. Terms on the same pair of
+// variables, (i,j) or (j,i), are merged. Returns an error if linbeg does
+// not start at 0 and never decrease, or if a linear index or a term refers
+// to a constraint or variable that does not exist.
+// The constraints get consecutive indices, the first one is assigned to idx;
+// pass NULL if not needed.
+CSIP_RETCODE CSIPaddQuadConss(
+    CSIP_MODEL *model, int ncons, int *linbeg, int *linindices,
+    double *lincoefs, int numquadterms, int *quadconsindices,
+    int *quadrowindices, int *quadcolindices, double *quadcoefs, double *lhs,
+    double *rhs, int *idx);
+
 // Add new nonlinear constraint to the model, of the form:
 //    lhs <= expression <= rhs
 // For one-sided inequalities, use (-)INFINITY for lhs or rhs.
@@ -134,6 +254,44 @@ CSIP_RETCODE CSIPaddNonLinCons(
     CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
     double *values, double lhs, double rhs, int *idx);
 
+// Add ncons nonlinear constraints at once, lhs[c] <= expression_c <= rhs[c].
+// The ops of all expressions are concatenated, the ops of constraint c are
+// the entries consbeg[c] until consbeg[c+1]-1. children, begin and values
+// are as in CSIPaddNonLinCons, with these differences:
+// - begin indexes into the concatenated children array (begin[0] is 0),
+// - children of ops that are ops refer to the op's position within its own
+//   constraint, so ops and children of separate expressions can simply be
+//   concatenated,
+// - values is one table of constants shared by all constraints.
+// The structure of every expression is checked first; if one is malformed
+// (wrong number of children, a child that does not precede its op, or a
+// variable that does not exist), an error is returned and nothing is added.
+// The constraints get consecutive indices, the first one is assigned to idx;
+// pass NULL if not needed.
+CSIP_RETCODE CSIPaddNonLinConss(
+    CSIP_MODEL *model, int ncons, int *consbeg, CSIP_OP *ops, int *children,
+    int *begin, double *values, double *lhs, double *rhs, int *idx);
+
+// Register a nonlinear expression as a template for CSIPaddNonLinConsFromTemplate.
+// The expression is given as in CSIPaddNonLinCons, except that the child of
+// VARIDX is a slot in 0..nslots-1 instead of a variable index. The structure
+// is checked here, once. The template index is assigned to tid.
+CSIP_RETCODE CSIPregisterExprTemplate(
+    CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
+    double *values, int nslots, int *tid);
+
+// Add ninst nonlinear constraints lhs[k] <= template_k <= rhs[k], where the
+// slots of instance k are the variables slotvars[k*nslots] until
+// slotvars[(k+1)*nslots-1]. If constants is not NULL, instance k uses the
+// values constants[k*nvalues] until constants[(k+1)*nvalues-1] instead of
+// those of the template, where nvalues is the number of values the template
+// refers to (largest index of a CONST child plus one).
+// The constraints get consecutive indices, the first one is assigned to idx;
+// pass NULL if not needed.
+CSIP_RETCODE CSIPaddNonLinConsFromTemplate(
+    CSIP_MODEL *model, int tid, int ninst, int *slotvars, double *constants,
+    double *lhs, double *rhs, int *idx);
+
 // Add SOS1 (special ordered set of type 1) constraint on a set of
 // variables. That is, at most one variable is allowed to take on a
 // nonzero value.
@@ -150,10 +308,64 @@ CSIP_RETCODE CSIPaddSOS1(
 CSIP_RETCODE CSIPaddSOS2(
     CSIP_MODEL *model, int numindices, int *indices, double *weights, int *idx);
 
+// Add nsets SOS constraints of the given type at once. The variables of set s
+// are given by the entries setbeg[s] until setbeg[s+1]-1 of indices and
+// weights. Pass NULL for weights to use the given variable order.
+// The constraints get consecutive indices, the first one is assigned to idx;
+// pass NULL if not needed.
+CSIP_RETCODE CSIPaddSOSBatch(
+    CSIP_MODEL *model, CSIP_SOSTYPE type, int nsets, int *setbeg, int *indices,
+    double *weights, int *idx);
+
+// Add an orbitope constraint for symmetry breaking: the columns of the
+// nrows x ncols matrix of distinct binary variables varmatrix (row-major,
+// variable indices) may be permuted without changing the problem. Only
+// solutions with lexicographically sorted columns are kept. The rows must be
+// set packing (sum <= 1) or partitioning (sum == 1) constraints of the model,
+// as given by type; the orbitope does not add them.
+// The constraint index will be assigned to idx; pass NULL if not needed.
+CSIP_RETCODE CSIPaddOrbitope(
+    CSIP_MODEL *model, int nrows, int ncols, int *varmatrix,
+    CSIP_ORBITOPETYPE type, int *idx);
+
+// Add an orbitope for nblocks interchangeable blocks of binary variables,
+// e.g. the assignment variables of identical machines. Block b consists of
+// blockvars[b*blocksize] until blockvars[(b+1)*blocksize-1], where the k-th
+// variables of all blocks correspond to each other. For every k, the model
+// must contain a linear constraint sum_b var_bk <= 1 or == 1, which
+// determines the type of the orbitope. Returns an error otherwise.
+// The constraint index will be assigned to idx; pass NULL if not needed.
+CSIP_RETCODE CSIPaddSymmetricBlocks(
+    CSIP_MODEL *model, int nblocks, int blocksize, int *blockvars, int *idx);
+
+// Add a bound disjunction constraint: at least one of the bounds
+//    vars[indices[i]] >= bounds[i]  if boundtypes[i] == CSIP_BOUNDTYPE_LOWER
+//    vars[indices[i]] <= bounds[i]  if boundtypes[i] == CSIP_BOUNDTYPE_UPPER
+// must hold, e.g. x <= 3 OR y >= 7.
+// The constraint index will be assigned to idx; pass NULL if not needed.
+CSIP_RETCODE CSIPaddBoundDisjunction(
+    CSIP_MODEL *model, int n, int *indices, CSIP_BOUNDTYPE *boundtypes,
+    double *bounds, int *idx);
+
+// Add a cumulative resource constraint: job j starts at the integer variable
+// vars[startvars[j]], runs for durations[j] time units and uses demands[j]
+// units of a resource with the given capacity. At any time, the total demand
+// of the running jobs must not exceed capacity.
+// The constraint index will be assigned to idx; pass NULL if not needed.
+CSIP_RETCODE CSIPaddCumulative(
+    CSIP_MODEL *model, int njobs, int *startvars, int *durations, int *demands,
+    int capacity, int *idx);
+
 // Set the linear objective function of the form: sum_i coefs[i] * vars[i]
 CSIP_RETCODE CSIPsetObj(
     CSIP_MODEL *model, int numindices, int *indices, double *coefs);
 
+// Replace the linear objective function by sum_i coefs[i] * vars[i]. All
+// other objective coefficients are set to zero; this only costs time in the
+// number of nonzeros of the previous objective.
+CSIP_RETCODE CSIPreplaceObj(
+    CSIP_MODEL *model, int numindices, int *indices, double *coefs);
+
 // Set a quadratic objective function
 CSIP_RETCODE CSIPsetQuadObj(CSIP_MODEL *model, int numlinindices,
                             int *linindices, double *lincoefs, int numquadterms,
@@ -166,6 +378,19 @@ CSIP_RETCODE CSIPsetNonlinearObj(
     CSIP_MODEL *model, int nops, int *ops, int *children, int *begin,
     double *values);
 
+// Declare the curvature of the expression of a nonlinear constraint, or of
+// the nonlinear objective (reset by CSIPsetNonlinearObj). If every nonlinear
+// constraint is declared convex where it has a finite rhs and concave where
+// it has a finite lhs, and the objective is convex when minimizing or concave
+// when maximizing, SCIP skips curvature detection and treats the problem as
+// convex (constraints/nonlinear/assumeconvex is set for the solve). Otherwise
+// that parameter keeps the user's value. Wrong declarations may lead to wrong
+// results.
+CSIP_RETCODE CSIPsetNonLinConsCurvature(
+    CSIP_MODEL *model, int considx, CSIP_CURVATURE curvature);
+CSIP_RETCODE CSIPsetNonlinearObjCurvature(
+    CSIP_MODEL *model, CSIP_CURVATURE curvature);
+
 // Set the optimization sense to minimization. This is the default setting.
 CSIP_RETCODE CSIPsetSenseMinimize(CSIP_MODEL *model);
 
@@ -178,10 +403,41 @@ CSIP_RETCODE CSIPsolve(CSIP_MODEL *model);
 // Interrupt the solving process.
 CSIP_RETCODE CSIPinterrupt(CSIP_MODEL *model);
 
+// Try to improve the best known solution for at most timebudget seconds,
+// after CSIPsolve stopped on a limit. The search is resumed for a bounded
+// number of nodes, pruned by the incumbent, with improvement heuristics
+// around it (RINS, local branching) run at every node and without adding
+// cuts; the gap, stall node, solution and best solution limits are ignored
+// meanwhile.
+// Parameters are restored afterwards. Results are read as after CSIPsolve;
+// the search need not finish. Fails if there is no solution; does nothing if
+// the search is finished.
+CSIP_RETCODE CSIPpolish(CSIP_MODEL *model, double timebudget);
+
 // Copy the values of all variables in the best known solution into
 // the output array. The user is responsible for memory allocation.
 CSIP_RETCODE CSIPgetVarValues(CSIP_MODEL *model, double *output);
 
+// Get the variables whose values in the best known solution differ from a
+// baseline by more than a tolerance (see CSIPsetVarValueTolerance), and
+// their new values. The baseline are the values returned by the previous call
+// (so, after one call per solve, the values of the previous solve), or set by
+// CSIPsetVarValueBaseline; without one, all variables are returned. The
+// returned values become the new baseline. indices and newvalues must have
+// room for all variables.
+CSIP_RETCODE CSIPgetVarValueChanges(
+    CSIP_MODEL *model, int *nchanged, int *indices, double *newvalues);
+
+// Set the baseline of CSIPgetVarValueChanges to the given values of all
+// variables; NaN values count as changed. Pass NULL to clear it.
+CSIP_RETCODE CSIPsetVarValueBaseline(CSIP_MODEL *model, double *values);
+
+// Set the tolerance of CSIPgetVarValueChanges: values count as changed if
+// they differ from the baseline by more than tolerance, in absolute terms.
+// Pass a negative value for the feasibility tolerance (numerics/feastol,
+// relative for large values), which is the default.
+CSIP_RETCODE CSIPsetVarValueTolerance(CSIP_MODEL *model, double tolerance);
+
 // Get the objective value of the best-known solution.
 double CSIPgetObjValue(CSIP_MODEL *model);
 
@@ -191,6 +447,31 @@ double CSIPgetObjBound(CSIP_MODEL *model);
 // Get the solving status.
 CSIP_STATUS CSIPgetStatus(CSIP_MODEL *model);
 
+// Get an estimate of the progress of the solving process. The estimate is
+// updated after every node, so it can be queried from callbacks, or read while
+// another thread is solving (then values can be slightly out of date).
+// After a finished solve, treeweight and gapclosed are 1.
+CSIP_RETCODE CSIPgetProgressEstimate(CSIP_MODEL *model, CSIP_PROGRESS *est);
+
+// Get the variables of nonlinear constraint considx, or of the nonlinear
+// objective for considx = -1, in ascending order. They are the sparsity
+// pattern of the gradients computed by CSIPevalGradBatch. Pass indices = NULL
+// to only get nvars.
+CSIP_RETCODE CSIPgetNonLinVars(
+    CSIP_MODEL *model, int considx, int *nvars, int *indices);
+
+// Evaluate the function of nonlinear constraint considx (or of the nonlinear
+// objective for considx = -1) and its gradient at npoints points. Point p is
+// points[p * n] .. points[p * n + n - 1], with n the number of variables of
+// the model. Its value is stored in vals[p] (NaN outside the domain of the
+// function) and its gradient in grads[p * m] .. grads[p * m + m - 1], with
+// entries for the m variables given by CSIPgetNonLinVars. The expression is
+// compiled on the first call, gradients are computed in reverse mode.
+// Must not be called concurrently on the same model.
+CSIP_RETCODE CSIPevalGradBatch(
+    CSIP_MODEL *model, int considx, int npoints, double *points, double *vals,
+    double *grads);
+
 // Get the type of a parameter
 CSIP_PARAMTYPE CSIPgetParamType(CSIP_MODEL *model, const char *name);
 
@@ -198,6 +479,10 @@ CSIP_PARAMTYPE CSIPgetParamType(CSIP_MODEL *model, const char *name);
 CSIP_RETCODE CSIPsetBoolParam(
     CSIP_MODEL *model, const char *name, int value);
 
+// Get the value of an existing boolean parameter
+CSIP_RETCODE CSIPgetBoolParam(
+    CSIP_MODEL *model, const char *name, int *value);
+
 // Set the value of an existing int parameter
 CSIP_RETCODE CSIPsetIntParam(
     CSIP_MODEL *model, const char *name, int value);
@@ -230,6 +515,116 @@ int CSIPgetNumConss(CSIP_MODEL *model);
 // values with NaN.
 CSIP_RETCODE CSIPsetInitialSolution(CSIP_MODEL *model, double *values);
 
+// Repair an infeasible initial solution at the start of CSIPsolve, spending
+// at most timebudget seconds: the solution closest to it (fewest flipped
+// binaries, then smallest L1 distance of the other variables) is searched for
+// and added instead. If the model rejects the repaired solution, the status is
+// CSIP_INITSOL_INFEASIBLE. Use timebudget = 0 to discard infeasible solutions
+// (the default).
+CSIP_RETCODE CSIPsetInitialSolutionRepair(CSIP_MODEL *model, double timebudget);
+
+// Get what became of the initial solution in the last call of CSIPsolve.
+CSIP_INITSOLSTATUS CSIPgetInitialSolutionStatus(CSIP_MODEL *model);
+
+// Pin the worker threads of parallel operations on this model
+// (CSIPsolveScenarios, CSIPbenders) to CPU sets: worker w runs on
+// cpus[beg[s]] .. cpus[beg[s + 1] - 1], with s = w % nsets. Worker 0 is the
+// calling thread, its affinity is restored afterwards. Models copied by
+// CSIPsolveScenarios are created by their worker after pinning, so their
+// memory is allocated on the NUMA node of that worker. Use nsets = 0 to let
+// workers run anywhere (default). Workers that can not be pinned run anywhere,
+// with a warning.
+CSIP_RETCODE CSIPsetWorkerCPUs(CSIP_MODEL *model, int nsets, int *beg,
+                               int *cpus);
+
+// Run the workers of parallel operations on this model (CSIPsolveScenarios,
+// CSIPbenders) as jobs of the given executor, instead of threads created by
+// CSIP. The executor is copied; pass NULL to use own threads again. The
+// calling thread is one of the workers, the other nthreads - 1 (at most
+// concurrency - 1) are submitted as jobs and then waited for. As the calling
+// thread does all work not taken by jobs, wait should run a job that has not
+// started yet inline, so that a busy executor can not deadlock. Worker CPU
+// sets are not applied to jobs.
+CSIP_RETCODE CSIPsetExecutor(CSIP_MODEL *model, CSIP_EXECUTOR *executor);
+
+// Set the executor of all models that have none set by CSIPsetExecutor.
+CSIP_RETCODE CSIPsetGlobalExecutor(CSIP_EXECUTOR *executor);
+
+// Make parallel operations on this model (CSIPsolveScenarios, CSIPbenders)
+// independent of the number of threads and of scheduling. What is
+// guaranteed: the result of each scenario depends only on the base model and
+// its delta, not on which thread solved it or which scenarios that thread
+// solved before (solutions are then not reused between scenarios, which may
+// cost some speed); Benders subproblems are always solved and cut in a fixed
+// order. What is not: solves that hit a time limit, whose results depend on
+// timing, and SCIP's concurrent solver beyond its own deterministic mode,
+// which this also sets if available (turning this off again leaves that mode
+// as it is). There are no work-unit races or shared incumbents between
+// threads to make deterministic: each scenario or subproblem is a separate,
+// sequential SCIP solve. Off by default.
+CSIP_RETCODE CSIPsetDeterministic(CSIP_MODEL *model, int deterministic);
+
+// Solve nscen variants of the base model, using nthreads threads. Each thread
+// works on its own copy of base, applies the changes in deltas[i], solves and
+// writes results[i], then reverts the changes and continues with the next
+// scenario. The base model is not modified and must not have callbacks.
+// Fails before solving anything if a scenario has an index out of range,
+// changes sides of a nonlinear constraint or gives a lhs above the rhs.
+CSIP_RETCODE CSIPsolveScenarios(
+    CSIP_MODEL *base, int nscen, CSIP_SCENARIO *deltas, int nthreads,
+    CSIP_SCENARIO_RESULT *results);
+
+// Solve model nsteps times, with new right-hand sides for the linear
+// constraints with indices considx[0..ncons-1]: rhsvalues[step * ncons + c]
+// replaces the finite side of constraint considx[c] (both sides of
+// equalities). From the second step on, the previous solution is the initial
+// solution: with a repair budget (CSIPsetInitialSolutionRepair), all of it is
+// given and repaired if the new sides make it infeasible; otherwise only its
+// integer values are given, for SCIP to complete, and the hint is dropped if
+// no completion is feasible. Pure LPs get no warm start. results[step] is
+// written as in CSIPsolveScenarios. The original sides are restored at the
+// end. Fails without changes if an index is out of range or a constraint is
+// not linear.
+CSIP_RETCODE CSIPsweepRHS(
+    CSIP_MODEL *model, int ncons, int *considx, int nsteps, double *rhsvalues,
+    CSIP_SCENARIO_RESULT *results);
+
+// Set up a Benders decomposition with master and nsubs >= 1 subproblems,
+// which must all be minimization problems. Subproblems must be continuous and
+// have no callbacks. All arguments are checked before any model is changed;
+// on an error nothing is set up. Master variable masterindices[j] is linked
+// to variable subindices[k * nlinks + j] of subproblem k; for each link, CSIP
+// adds a variable and a constraint to each subproblem to fix that variable,
+// and a variable eta_k with lower bound sublowerbounds[k] to the master
+// (index in etaindices[k]; pass NULL if not needed). A lazy callback on master then solves the subproblems with
+// nthreads threads and adds optimality cuts from their duals. Infeasible
+// subproblems are cut off with no-good cuts, valid for binary linking
+// variables only; otherwise subproblems must always be feasible, and an
+// infeasible one is an error of the callback.
+// Subproblems must be freed by the user, after master.
+CSIP_RETCODE CSIPbenders(
+    CSIP_MODEL *master, int nsubs, CSIP_MODEL **subs, int nlinks,
+    int *masterindices, int *subindices, double *sublowerbounds, int nthreads,
+    int *etaindices);
+
+// Record all following API calls on model, with their arguments, to a binary
+// file at path. Constraints added in lazy callbacks and solutions added in
+// heuristic callbacks are recorded as events. The file is written in native
+// byte order and can be replayed with CSIPreplayRecording or csip-replay.
+CSIP_RETCODE CSIPstartRecording(CSIP_MODEL *model, const char *path);
+
+// Stop recording and close the file.
+CSIP_RETCODE CSIPstopRecording(CSIP_MODEL *model);
+
+// Create a new model and apply all calls recorded in the file at path,
+// including the solves. Instead of the recorded callbacks, recorded lazy
+// constraints are added when violated and recorded heuristic solutions are
+// given to the solver. Recorded and replayed results of each solve are
+// printed as info messages. Truncated or corrupt files and calls that fail
+// give an error and *model = NULL. Calls that are rejected with an error
+// when recording are not recorded.
+CSIP_RETCODE CSIPreplayRecording(const char *path, CSIP_MODEL **model);
+
 /* lazy constraint callback functions */
 
 typedef struct SCIP_ConshdlrData CSIP_LAZYDATA;
@@ -249,6 +644,11 @@ CSIP_RETCODE CSIPlazyAddLinCons(
     CSIP_LAZYDATA *lazydata, int numindices, int *indices, double *coefs,
     double lhs, double rhs, int islocal);
 
+// Whether the callback should return as soon as possible, because it is over
+// its time budget (see CSIPsetCallbackBudget) or the solve was interrupted or
+// hit a limit. Returns 1 if so, 0 otherwise.
+int CSIPlazyShouldStop(CSIP_LAZYDATA *lazydata);
+
 typedef CSIP_RETCODE(*CSIP_LAZYCALLBACK)(
     CSIP_MODEL *model, CSIP_LAZYDATA *lazydata, void *userdata);
 
@@ -273,11 +673,42 @@ CSIP_RETCODE CSIPheurGetVarValues(CSIP_HEURDATA *heurdata, double *output);
 // Supply a solution (as a dense array). Only complete solutions are supported.
 CSIP_RETCODE CSIPheurAddSolution(CSIP_HEURDATA *heurdata, double *values);
 
+// Like CSIPlazyShouldStop, for heuristic callbacks.
+int CSIPheurShouldStop(CSIP_HEURDATA *heurdata);
+
 // Add a heuristic callback to the model.
 // You may use userdata to pass any data.
 CSIP_RETCODE CSIPaddHeuristicCallback(
     CSIP_MODEL *model, CSIP_HEURCALLBACK heur, void *userdata);
 
+/* callback time budgets */
+
+// Set a wall clock time budget (in seconds, <= 0 for none) for each call of
+// a callback. Callbacks of each type are numbered in the order they were
+// added, starting from 0. Each time a callback has overrun its budget
+// maxoverruns times, a heuristic is called half as often from then on, while
+// a lazy constraint callback (which can not be skipped) is flagged in its
+// statistics, with a warning the first time.
+CSIP_RETCODE CSIPsetCallbackBudget(
+    CSIP_MODEL *model, CSIP_CALLBACKTYPE type, int cbidx, double timebudget,
+    int maxoverruns);
+
+// Get the running time statistics of a callback.
+CSIP_RETCODE CSIPgetCallbackStats(
+    CSIP_MODEL *model, CSIP_CALLBACKTYPE type, int cbidx,
+    CSIP_CALLBACK_STATS *stats);
+
+/* metrics */
+
+// Write metrics aggregated over all models of the process to the file
+// descriptor fd, in OpenMetrics text format: solves started and completed
+// (by status), a solving time histogram, nodes, lazy constraints, time spent
+// in callbacks and the largest memory use of a model, as reported by SCIP
+// after each node and solve (this is neither the process peak nor a
+// high-water mark of SCIP's allocations). Models add to the metrics at the
+// end of each solve. Safe to call from any thread.
+CSIP_RETCODE CSIPwriteMetrics(int fd);
+
 /* advanced usage */
 
 // Get access to the internal SCIP solver. Use at your own risk!
@@ -1,6 +1,14 @@
+// for CPU affinity of threads
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
 #include <string.h>
+#include <time.h>
 
 #include "csip.h"
+#include "nlpi/exprinterpret.h"
 #include "nlpi/pub_expr.h"
 #include "scip/scip.h"
 #include "scip/pub_misc.h"
@@ -64,10 +72,63 @@ static inline int retCodeCSIPtoSCIP(int csipRetCode)
 // catch CSIP return code from SCIP
 #define CSIP_in_SCIP(x) SCIP_CALL( retCodeCSIPtoSCIP(x) )
 
+// static tracepoints (USDT) for bpftrace/perf, enabled by building with
+// -DCSIP_USDT (make USDT=true). Otherwise they compile to nothing.
+#ifdef CSIP_USDT
+#include <sys/sdt.h>
+#define CSIP_PROBE1(name, a) DTRACE_PROBE1(csip, name, a)
+#define CSIP_PROBE2(name, a, b) DTRACE_PROBE2(csip, name, a, b)
+#define CSIP_PROBE3(name, a, b, c) DTRACE_PROBE3(csip, name, a, b, c)
+#else
+#define CSIP_PROBE1(name, a) do {} while (0)
+#define CSIP_PROBE2(name, a, b) do {} while (0)
+#define CSIP_PROBE3(name, a, b, c) do {} while (0)
+#endif
+
 // variable sized arrays
 #define INITIALSIZE 64
 #define GROWFACTOR   2
 
+// CPU sets for worker threads, set s is cpus[beg[s]] .. cpus[beg[s + 1] - 1]
+struct cpu_sets
+{
+    int nsets;
+    int *beg;
+    int *cpus;
+};
+
+// metrics of a model not yet added to the global registry
+struct model_metrics
+{
+    long long lazyconss;
+    double lazytime;
+    double heurtime;
+    long long memsampled;     // largest SCIPgetMemUsed at progress updates
+};
+
+// copy of an expression tree compiled for gradient evaluation
+struct grad_eval
+{
+    SCIP_EXPRTREE *tree;           // NULL if not compiled yet
+    int *treevaridx;               // index of each variable of tree
+    int nvars;                     // distinct variables, ascending
+    int *varidx;
+    int *slot;                     // position in varidx of each tree variable
+};
+
+// nonlinear expression whose variables are slots, see CSIPregisterExprTemplate
+struct expr_template
+{
+    int nops;
+    CSIP_OP *ops;
+    int *children;
+    int *begin;
+    double *values;
+    int nvalues;
+    int nslots;
+    int maxchildren;
+};
+
 struct csip_model
 {
     SCIP *scip;
@@ -77,11 +138,25 @@ struct csip_model
     int varssize;
     SCIP_VAR **vars;
 
+    // support of linear objective (may contain zeros), sized like vars
+    int nobjsupport;
+    int *objsupport;
+    SCIP_Bool *inobjsupport;
+
     // variable sized array for constraints
     int nconss;
     int consssize;
     SCIP_CONS **conss;
 
+    // user-declared curvature of nonlinear constraints, sized like conss, and
+    // of the nonlinear objective
+    CSIP_CURVATURE *conscurvature;
+    CSIP_CURVATURE objcurvature;
+
+    // whether the hints have set assumeconvex, and its value before
+    SCIP_Bool assumeconvexset;
+    SCIP_Bool userassumeconvex;
+
     // counter for callbacks
     int nlazycb;
     int nheur;
@@ -89,6 +164,11 @@ struct csip_model
     // user-defined solution, is checked before solving
     SCIP_SOL *initialsol;
 
+    // time for repairing an infeasible initial solution (0: no repair), and
+    // what became of the initial solution in the last solve
+    double repairbudget;
+    CSIP_INITSOLSTATUS initialsolstatus;
+
     // store objective variable for nonlinear objective: the idea is to add an
     // auxiliary constraint and variable to represent nonlinear objectives. If
     // the objective gets change, we set to 0 the objective coefficient of this
@@ -100,12 +180,69 @@ struct csip_model
 
     // store message handler to allow for a prefix
     SCIP_MESSAGEHDLR* msghdlr;
+
+    // Benders decomposition, if set up with this model as master
+    struct benders_data *benders;
+
+    // where worker threads of parallel operations run
+    struct cpu_sets workercpus;
+
+    // runs the workers of parallel operations instead of own threads, if set
+    SCIP_Bool hasexecutor;
+    CSIP_EXECUTOR executor;
+
+    // whether parallel operations must give the same results for any number
+    // of threads, see CSIPsetDeterministic
+    SCIP_Bool deterministic;
+
+    // file to record API calls to, see CSIPstartRecording
+    FILE *recording;
+
+    // recorded calls and events, if model was created by CSIPreplayRecording
+    struct replay_data *replay;
+
+    // expressions compiled for CSIPevalGradBatch, of the constraints (sized
+    // like conss when used) and of the objective; variable indices by variable
+    int ngradevals;
+    struct grad_eval *gradevals;
+    struct grad_eval objgradeval;
+    SCIP_EXPRINT *exprint;
+    int nvarindex;
+    SCIP_HASHMAP *varindex;
+
+    // values of the variables last returned by CSIPgetVarValueChanges, or
+    // given by CSIPsetVarValueBaseline, for the first nbasevalues variables
+    int nbasevalues;
+    double *basevalues;
+    // tolerance of CSIPgetVarValueChanges, < 0 for the feasibility tolerance
+    double basetolerance;
+
+    // variable sized array for expression templates
+    int ntemplates;
+    int templatessize;
+    struct expr_template *templates;
+
+    // progress estimate, updated by an event handler after every node; it is
+    // only written by the solving thread, and under progresslock
+    CSIP_PROGRESS progress;
+    pthread_mutex_t progresslock;
+    double rootgap;
+
+    // flushed to the global registry after every solve
+    struct model_metrics metrics;
 };
 
 /*
  * local methods
  */
 
+// defined with the Benders decomposition and replay below
+static void freeBenders(struct benders_data *benders);
+static void freeReplay(struct replay_data *replay);
+static CSIP_RETCODE freeGradEval(struct grad_eval *gradeval);
+static CSIP_RETCODE setPrefixMessagehdlr(CSIP_MODEL *model, const char* prefix);
+static const char *getMessagePrefix(CSIP_MODEL *model);
+
 static
 CSIP_RETCODE createLinCons(CSIP_MODEL *model, int numindices, int *indices,
                            double *coefs, double lhs, double rhs, SCIP_CONS **cons)
@@ -143,11 +280,15 @@ CSIP_RETCODE addCons(CSIP_MODEL *model, SCIP_CONS *cons, int *idx)
         model->consssize = GROWFACTOR * model->consssize;
         model->conss = (SCIP_CONS **) realloc(
                            model->conss,  model->consssize * sizeof(SCIP_CONS *));
-        if (model->conss == NULL)
+        model->conscurvature = (CSIP_CURVATURE *) realloc(
+                                   model->conscurvature,
+                                   model->consssize * sizeof(CSIP_CURVATURE));
+        if (model->conss == NULL || model->conscurvature == NULL)
         {
             return CSIP_RETCODE_NOMEMORY;
         }
     }
+    model->conscurvature[model->nconss] = CSIP_CURVATURE_UNKNOWN;
 
     if (idx != NULL)
     {
@@ -164,27 +305,54 @@ CSIP_RETCODE addCons(CSIP_MODEL *model, SCIP_CONS *cons, int *idx)
     return CSIP_RETCODE_OK;
 }
 
+// set objective coefficient of a variable, remember it if nonzero
 static
-CSIP_RETCODE createExprtree(
+CSIP_RETCODE setVarObj(CSIP_MODEL *model, int varidx, double coef)
+{
+    SCIP_in_CSIP(SCIPchgVarObj(model->scip, model->vars[varidx], coef));
+
+    if (coef != 0.0 && !model->inobjsupport[varidx])
+    {
+        model->inobjsupport[varidx] = TRUE;
+        model->objsupport[model->nobjsupport] = varidx;
+        ++(model->nobjsupport);
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+// free the transformed problem, before the original problem is modified
+static
+CSIP_RETCODE freeTransform(CSIP_MODEL *model)
+{
+    CSIP_PROBE2(freetransform__start, model, (int) SCIPgetStage(model->scip));
+    SCIP_in_CSIP(SCIPfreeTransform(model->scip));
+    CSIP_PROBE1(freetransform__done, model);
+
+    return CSIP_RETCODE_OK;
+}
+
+/* builds the expression tree of ops, VARIDX children index varmap; exprs and
+ * vars must have room for nops entries and childexprs for the largest number
+ * of children of an op */
+static
+CSIP_RETCODE buildExprtree(
     CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
-    double *values, SCIP_EXPRTREE **tree)
+    double *values, SCIP_VAR **varmap, SCIP_EXPR **exprs, SCIP_VAR **vars,
+    SCIP_EXPR **childexprs, SCIP_EXPRTREE **tree)
 {
     SCIP *scip;
-    SCIP_EXPR **exprs;
-    SCIP_VAR **vars;
     int varpos;
     int i;
     int nvars;
 
     scip = model->scip;
-    exprs = (SCIP_EXPR **) malloc(nops * sizeof(SCIP_EXPR *));
     nvars = 0;
     for (i = 0; i < nops; ++i)
     {
         exprs[i] = NULL;
         nvars += (ops[i] == SCIP_EXPR_VARIDX);
     }
-    vars = (SCIP_VAR **) malloc(nvars * sizeof(SCIP_VAR *));
 
     varpos = 0;
     for (i = 0; i < nops; ++i)
@@ -195,10 +363,9 @@ CSIP_RETCODE createExprtree(
             {
                 int varidx = children[begin[i]];
                 assert(1 == begin[i + 1] - begin[i]);
-                assert(varidx < model->nvars);
                 SCIP_in_CSIP(SCIPexprCreate(SCIPblkmem(scip), &exprs[i],
                                             ops[i], varpos));
-                vars[varpos] = model->vars[varidx];
+                vars[varpos] = varmap[varidx];
                 ++varpos;
                 //printf("Seeing variable %d (nchild %d)\n", varidx, begin[i+1] - begin[i]);
             }
@@ -256,19 +423,16 @@ CSIP_RETCODE createExprtree(
         case SCIP_EXPR_SUM:
         case SCIP_EXPR_PRODUCT:
             {
-                SCIP_EXPR **childrenexpr;
                 int nchildren = begin[i + 1] - begin[i];
                 int c;
-                childrenexpr = (SCIP_EXPR **) malloc(nchildren * sizeof(SCIP_EXPR *));
                 for (c = 0; c < nchildren; ++c)
                 {
-                    childrenexpr[c] = exprs[children[begin[i] + c]];
+                    childexprs[c] = exprs[children[begin[i] + c]];
                 }
 
                 SCIP_in_CSIP(SCIPexprCreate(SCIPblkmem(scip), &exprs[i],
-                                            ops[i], nchildren, childrenexpr));
+                                            ops[i], nchildren, childexprs));
 
-                free(childrenexpr);
                 //printf("Seeing a sum/product (nchild %d)\n",  begin[i+1] - begin[i]);
             }
             break;
@@ -286,11 +450,53 @@ CSIP_RETCODE createExprtree(
     // assign variables to tree
     SCIP_in_CSIP(SCIPexprtreeSetVars(*tree, nvars, vars));
 
-    // free memory
+    return CSIP_RETCODE_OK;
+}
+
+static
+int maxNumChildren(int nops, int *begin)
+{
+    int maxchildren = 0;
+    int i;
+
+    for (i = 0; i < nops; ++i)
+    {
+        maxchildren = MAX(maxchildren, begin[i + 1] - begin[i]);
+    }
+
+    return maxchildren;
+}
+
+static
+CSIP_RETCODE createExprtree(
+    CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
+    double *values, SCIP_EXPRTREE **tree)
+{
+    SCIP_EXPR **exprs;
+    SCIP_EXPR **childexprs;
+    SCIP_VAR **vars;
+    CSIP_RETCODE retcode;
+
+    exprs = (SCIP_EXPR **) malloc(nops * sizeof(SCIP_EXPR *));
+    vars = (SCIP_VAR **) malloc(nops * sizeof(SCIP_VAR *));
+    childexprs = (SCIP_EXPR **) malloc(
+                     MAX(1, maxNumChildren(nops, begin)) * sizeof(SCIP_EXPR *));
+    if (exprs == NULL || vars == NULL || childexprs == NULL)
+    {
+        free(childexprs);
+        free(vars);
+        free(exprs);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    retcode = buildExprtree(model, nops, ops, children, begin, values,
+                            model->vars, exprs, vars, childexprs, tree);
+
+    free(childexprs);
     free(vars);
     free(exprs);
 
-    return CSIP_RETCODE_OK;
+    return retcode;
 }
 
 static
@@ -304,6 +510,165 @@ char *strDup(const char *s) {
     return p;
 }
 
+/* API call recording: each call is written as an int opcode, followed by
+ * fields (tag, int count, raw data) and an end tag. Scalars are fields of
+ * count 1. Data is written in native byte order.
+ */
+#define RECORD_MAGIC 0x43534950 // "CSIP"
+#define RECORD_VERSION 1
+
+#define RECORD_END 'e'
+#define RECORD_NULL 'n'
+#define RECORD_INTS 'i'
+#define RECORD_LONGS 'l'
+#define RECORD_DOUBLES 'd'
+#define RECORD_CHARS 's'
+
+// opcodes
+#define RECORD_ADDVAR 1
+#define RECORD_CHGVARLB 2
+#define RECORD_CHGVARUB 3
+#define RECORD_CHGVARTYPE 4
+#define RECORD_ADDLINCONS 5
+#define RECORD_ADDQUADCONS 6
+#define RECORD_ADDNONLINCONS 7
+#define RECORD_ADDSOS1 8
+#define RECORD_ADDSOS2 9
+#define RECORD_SETOBJ 10
+#define RECORD_REPLACEOBJ 11
+#define RECORD_SETNONLINEAROBJ 12
+#define RECORD_SETSENSEMIN 13
+#define RECORD_SETSENSEMAX 14
+#define RECORD_SOLVE 15
+#define RECORD_SOLVED 16
+#define RECORD_SETBOOLPARAM 17
+#define RECORD_SETINTPARAM 18
+#define RECORD_SETLONGINTPARAM 19
+#define RECORD_SETREALPARAM 20
+#define RECORD_SETCHARPARAM 21
+#define RECORD_SETSTRINGPARAM 22
+#define RECORD_SETINITIALSOL 23
+#define RECORD_ADDLAZYCALLBACK 24
+#define RECORD_LAZYCONS 25
+#define RECORD_ADDHEURCALLBACK 26
+#define RECORD_HEURSOL 27
+#define RECORD_SETMESSAGEPREFIX 28
+#define RECORD_CHGLINCONSSIDES 29
+#define RECORD_ADDQUADCONSS 30
+#define RECORD_ADDSOSBATCH 31
+#define RECORD_ADDNONLINCONSS 32
+#define RECORD_REGISTEREXPRTEMPLATE 33
+#define RECORD_ADDNONLINCONSFROMTEMPLATE 34
+#define RECORD_SETNONLINCONSCURVATURE 35
+#define RECORD_SETNONLINEAROBJCURVATURE 36
+#define RECORD_ADDORBITOPE 37
+#define RECORD_ADDSYMMETRICBLOCKS 38
+#define RECORD_ADDBOUNDDISJUNCTION 39
+#define RECORD_ADDCUMULATIVE 40
+#define RECORD_SETCALLBACKBUDGET 41
+#define RECORD_SETDETERMINISTIC 42
+#define RECORD_POLISH 43
+#define RECORD_SETINITIALSOLREPAIR 44
+#define RECORD_MAXOP 44
+
+// fields of each opcode, by tag: lower case for scalars and strings, upper
+// case for arrays, which may also be NULL
+static const char *recordlayouts[RECORD_MAXOP + 1] =
+{
+    NULL, "ddi", "ID", "ID", "ii", "IDdd", "IDIIDdd", "IIIDdd", "ID", "ID",
+    "ID", "ID", "IIID", "", "", "", "ildd", "si", "si", "sl", "sd", "si", "ss",
+    "D", "", "IDddi", "", "D", "s", "idd", "IIDIIIDDD", "iIID", "IIIDIDD",
+    "IIIDi", "iiIDDD", "ii", "i", "iiIi", "iiI", "IID", "IIIi", "iidi", "i", "d",
+    "d"
+};
+
+static
+void recordOp(CSIP_MODEL *model, int op)
+{
+    fwrite(&op, sizeof(int), 1, model->recording);
+}
+
+static
+void recordArray(CSIP_MODEL *model, char tag, int n, const void *data,
+                 size_t size)
+{
+    if (data == NULL)
+    {
+        tag = RECORD_NULL;
+        n = 0;
+    }
+    fputc(tag, model->recording);
+    fwrite(&n, sizeof(int), 1, model->recording);
+    if (n > 0)
+    {
+        fwrite(data, size, n, model->recording);
+    }
+}
+
+static
+void recordInts(CSIP_MODEL *model, int n, const int *data)
+{
+    recordArray(model, RECORD_INTS, n, data, sizeof(int));
+}
+
+static
+void recordDoubles(CSIP_MODEL *model, int n, const double *data)
+{
+    recordArray(model, RECORD_DOUBLES, n, data, sizeof(double));
+}
+
+static
+void recordInt(CSIP_MODEL *model, int value)
+{
+    recordInts(model, 1, &value);
+}
+
+static
+void recordDouble(CSIP_MODEL *model, double value)
+{
+    recordDoubles(model, 1, &value);
+}
+
+static
+void recordString(CSIP_MODEL *model, const char *value)
+{
+    recordArray(model, RECORD_CHARS, strlen(value) + 1, value, sizeof(char));
+}
+
+static
+void recordEnd(CSIP_MODEL *model)
+{
+    fputc(RECORD_END, model->recording);
+}
+
+// number of values referenced by CONST operators of an expression
+static
+int exprNumValues(int nops, CSIP_OP *ops, int *children, int *begin)
+{
+    int nvalues = 0;
+    int i;
+
+    for (i = 0; i < nops; ++i)
+    {
+        if (ops[i] == CONST)
+        {
+            nvalues = MAX(nvalues, children[begin[i]] + 1);
+        }
+    }
+
+    return nvalues;
+}
+
+static
+void recordExpr(CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children,
+                int *begin, double *values)
+{
+    recordInts(model, nops, ops);
+    recordInts(model, begin[nops], children);
+    recordInts(model, nops + 1, begin);
+    recordDoubles(model, exprNumValues(nops, ops, children, begin), values);
+}
+
 /** When the objective is nonlinear we use the epigraph representation.
  * However, changing the objective sense is not  straightforward in that
  * case. The purpose of this function is to change an epigraph objective
@@ -346,6 +711,301 @@ CSIP_RETCODE correctObjectiveFunction(CSIP_MODEL *model)
     return CSIP_RETCODE_OK;
 }
 
+/*
+ * progress estimation
+ */
+
+/* The tree weight is the sum of 2^-depth over all leaves of the B&B tree,
+ * which reaches 1 when the tree is fully explored. We use it as the explored
+ * fraction and extrapolate the number of nodes and the remaining time. Nodes
+ * that are pruned in the queue without being processed are not counted, so
+ * the estimate is pessimistic until the end.
+ */
+
+struct SCIP_EventhdlrData
+{
+    CSIP_MODEL *model;
+};
+
+// publish a new estimate, for readers on other threads
+static
+void setProgress(CSIP_MODEL *model, CSIP_PROGRESS *progress)
+{
+    pthread_mutex_lock(&model->progresslock);
+    model->progress = *progress;
+    pthread_mutex_unlock(&model->progresslock);
+}
+
+static
+void resetProgress(CSIP_MODEL *model)
+{
+    CSIP_PROGRESS progress;
+
+    progress.nnodes = 0;
+    progress.treeweight = 0.0;
+    progress.gapclosed = 0.0;
+    progress.treesize = -1.0;
+    progress.remainingtime = -1.0;
+    setProgress(model, &progress);
+    model->rootgap = -1.0;
+}
+
+// treeweight is added to the tree weight before the estimate is updated
+static
+void updateProgress(CSIP_MODEL *model, double treeweight)
+{
+    SCIP *scip = model->scip;
+    CSIP_PROGRESS current = model->progress;
+    CSIP_PROGRESS *progress = &current;
+    double weight;
+    double gap = SCIPgetGap(scip);
+
+    progress->treeweight += treeweight;
+    weight = progress->treeweight;
+    progress->nnodes = SCIPgetNNodes(scip);
+    model->metrics.memsampled = MAX(model->metrics.memsampled, SCIPgetMemUsed(scip));
+
+    // remember first finite gap, to measure how much of it is closed
+    if (model->rootgap < 0.0 && !SCIPisInfinity(scip, gap))
+    {
+        model->rootgap = gap;
+    }
+    if (model->rootgap > 0.0 && !SCIPisInfinity(scip, gap))
+    {
+        progress->gapclosed = 1.0 - gap / model->rootgap;
+        progress->gapclosed = MAX(0.0, MIN(1.0, progress->gapclosed));
+    }
+
+    if (weight > 0.0)
+    {
+        weight = MIN(1.0, weight);
+        progress->treesize = progress->nnodes / weight;
+        progress->remainingtime = SCIPgetSolvingTime(scip)
+                                  * (1.0 - weight) / weight;
+    }
+    setProgress(model, progress);
+}
+
+static
+SCIP_DECL_EVENTEXEC(eventExecProgress)
+{
+    SCIP_EVENTHDLRDATA *eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    CSIP_MODEL *model = eventhdlrdata->model;
+    double leafweight = 0.0;
+
+    // feasible or infeasible nodes are leaves, branched nodes are not
+    if (SCIPeventGetType(event) != SCIP_EVENTTYPE_NODEBRANCHED)
+    {
+        int depth = SCIPnodeGetDepth(SCIPeventGetNode(event));
+        leafweight = ldexp(1.0, -depth);
+    }
+    updateProgress(model, leafweight);
+
+    return SCIP_OKAY;
+}
+
+// also called after a restart, when the tree starts over
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolProgress)
+{
+    SCIP_EVENTHDLRDATA *eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+
+    resetProgress(eventhdlrdata->model);
+    SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_NODESOLVED, eventhdlr, NULL,
+                             NULL));
+
+    return SCIP_OKAY;
+}
+
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolProgress)
+{
+    SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODESOLVED, eventhdlr, NULL,
+                            -1));
+
+    return SCIP_OKAY;
+}
+
+static
+SCIP_DECL_EVENTFREE(eventFreeProgress)
+{
+    SCIP_EVENTHDLRDATA *eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    assert(eventhdlrdata != NULL);
+
+    SCIPfreeMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, NULL);
+
+    return SCIP_OKAY;
+}
+
+static
+CSIP_RETCODE includeProgressEventhdlr(CSIP_MODEL *model)
+{
+    SCIP *scip = model->scip;
+    SCIP_EVENTHDLRDATA *eventhdlrdata;
+    SCIP_EVENTHDLR *eventhdlr;
+
+    SCIP_in_CSIP(SCIPallocMemory(scip, &eventhdlrdata));
+    eventhdlrdata->model = model;
+
+    SCIP_in_CSIP(SCIPincludeEventhdlrBasic(
+                     scip, &eventhdlr, "csip_progress",
+                     "tree weight and gap closure estimation",
+                     eventExecProgress, eventhdlrdata));
+    SCIP_in_CSIP(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolProgress));
+    SCIP_in_CSIP(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolProgress));
+    SCIP_in_CSIP(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeProgress));
+
+    return CSIP_RETCODE_OK;
+}
+
+/*
+ * Metrics
+ *
+ * All models add to one process-wide registry, under a lock, once at the
+ * start and once at the end of every solve. Counts within a solve are kept in
+ * the model.
+ */
+
+#define METRICS_NBUCKETS 7
+#define METRICS_NSTATUS 9
+
+static const double solvetimebuckets[METRICS_NBUCKETS] =
+{
+    0.001, 0.01, 0.1, 1.0, 10.0, 100.0, 1000.0
+};
+
+// indexed by CSIP_STATUS
+static const char *statusnames[METRICS_NSTATUS] =
+{
+    "optimal", "infeasible", "unbounded", "inforunbd", "nodelimit",
+    "timelimit", "memlimit", "userlimit", "unknown"
+};
+
+struct metrics_registry
+{
+    long long solvesstarted;
+    long long solvescompleted[METRICS_NSTATUS];
+    long long solvetimecounts[METRICS_NBUCKETS]; // not cumulative
+    double solvetimesum;
+    long long nnodes;
+    long long lazyconss;
+    double lazytime;
+    double heurtime;
+    long long memsampled;
+};
+
+static struct metrics_registry metrics;
+static pthread_mutex_t metricslock = PTHREAD_MUTEX_INITIALIZER;
+
+static
+void resetModelMetrics(CSIP_MODEL *model)
+{
+    model->metrics.lazyconss = 0;
+    model->metrics.lazytime = 0.0;
+    model->metrics.heurtime = 0.0;
+    model->metrics.memsampled = 0;
+}
+
+static
+void metricsSolveStarted(void)
+{
+    pthread_mutex_lock(&metricslock);
+    ++metrics.solvesstarted;
+    pthread_mutex_unlock(&metricslock);
+}
+
+static
+void flushMetrics(CSIP_MODEL *model)
+{
+    SCIP *scip = model->scip;
+    double solvetime = SCIPgetSolvingTime(scip);
+    int status = CSIPgetStatus(model);
+    int b = 0;
+
+    // times above the largest bucket only count for +Inf
+    while (b < METRICS_NBUCKETS && solvetime > solvetimebuckets[b])
+    {
+        ++b;
+    }
+
+    pthread_mutex_lock(&metricslock);
+    ++metrics.solvescompleted[status];
+    if (b < METRICS_NBUCKETS)
+    {
+        ++metrics.solvetimecounts[b];
+    }
+    metrics.solvetimesum += solvetime;
+    metrics.nnodes += SCIPgetNNodes(scip);
+    metrics.lazyconss += model->metrics.lazyconss;
+    metrics.lazytime += model->metrics.lazytime;
+    metrics.heurtime += model->metrics.heurtime;
+    metrics.memsampled = MAX(metrics.memsampled, model->metrics.memsampled);
+    pthread_mutex_unlock(&metricslock);
+
+    resetModelMetrics(model);
+}
+
+CSIP_RETCODE CSIPwriteMetrics(int fd)
+{
+    struct metrics_registry m;
+    long long ncompleted = 0;
+    long long cumulative = 0;
+    int ok = 1;
+    int i;
+
+    pthread_mutex_lock(&metricslock);
+    m = metrics;
+    pthread_mutex_unlock(&metricslock);
+
+    ok &= dprintf(fd, "# TYPE csip_solves_started counter\n"
+                  "# HELP csip_solves_started Solves started.\n"
+                  "csip_solves_started_total %lld\n", m.solvesstarted) >= 0;
+
+    ok &= dprintf(fd, "# TYPE csip_solves_completed counter\n"
+                  "# HELP csip_solves_completed Solves completed, by status.\n") >= 0;
+    for (i = 0; i < METRICS_NSTATUS; ++i)
+    {
+        ncompleted += m.solvescompleted[i];
+        ok &= dprintf(fd, "csip_solves_completed_total{status=\"%s\"} %lld\n",
+                      statusnames[i], m.solvescompleted[i]) >= 0;
+    }
+
+    ok &= dprintf(fd, "# TYPE csip_solve_seconds histogram\n"
+                  "# HELP csip_solve_seconds Solving time.\n") >= 0;
+    for (i = 0; i < METRICS_NBUCKETS; ++i)
+    {
+        cumulative += m.solvetimecounts[i];
+        ok &= dprintf(fd, "csip_solve_seconds_bucket{le=\"%g\"} %lld\n",
+                      solvetimebuckets[i], cumulative) >= 0;
+    }
+    ok &= dprintf(fd, "csip_solve_seconds_bucket{le=\"+Inf\"} %lld\n"
+                  "csip_solve_seconds_sum %.17g\n"
+                  "csip_solve_seconds_count %lld\n",
+                  ncompleted, m.solvetimesum, ncompleted) >= 0;
+
+    ok &= dprintf(fd, "# TYPE csip_nodes counter\n"
+                  "# HELP csip_nodes Branch-and-bound nodes processed.\n"
+                  "csip_nodes_total %lld\n", m.nnodes) >= 0;
+    ok &= dprintf(fd, "# TYPE csip_lazy_constraints counter\n"
+                  "# HELP csip_lazy_constraints Constraints added by lazy "
+                  "callbacks.\n"
+                  "csip_lazy_constraints_total %lld\n", m.lazyconss) >= 0;
+    ok &= dprintf(fd, "# TYPE csip_callback_seconds counter\n"
+                  "# HELP csip_callback_seconds Wall clock time in callbacks.\n"
+                  "csip_callback_seconds_total{type=\"lazy\"} %.17g\n"
+                  "csip_callback_seconds_total{type=\"heuristic\"} %.17g\n",
+                  m.lazytime, m.heurtime) >= 0;
+    ok &= dprintf(fd, "# TYPE csip_model_memory_sampled_max_bytes gauge\n"
+                  "# HELP csip_model_memory_sampled_max_bytes Largest memory "
+                  "use of one SCIP instance, sampled after nodes and solves; "
+                  "not the peak of the process.\n"
+                  "csip_model_memory_sampled_max_bytes %lld\n"
+                  "# EOF\n", m.memsampled) >= 0;
+
+    return ok ? CSIP_RETCODE_OK : CSIP_RETCODE_ERROR;
+}
+
 /*
  * interface methods
  */
@@ -395,22 +1055,61 @@ CSIP_RETCODE CSIPcreateModel(CSIP_MODEL **modelptr)
         return CSIP_RETCODE_NOMEMORY;
     }
 
+    model->nobjsupport = 0;
+    model->objsupport = (int *) malloc(INITIALSIZE * sizeof(int));
+    model->inobjsupport = (SCIP_Bool *) malloc(INITIALSIZE * sizeof(SCIP_Bool));
+    if (model->objsupport == NULL || model->inobjsupport == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
     model->nconss = 0;
     model->consssize = INITIALSIZE;
     model->conss = (SCIP_CONS **) malloc(INITIALSIZE * sizeof(SCIP_CONS *));
-    if (model->conss == NULL)
+    model->conscurvature = (CSIP_CURVATURE *) malloc(
+                               INITIALSIZE * sizeof(CSIP_CURVATURE));
+    if (model->conss == NULL || model->conscurvature == NULL)
     {
         return CSIP_RETCODE_NOMEMORY;
     }
+    model->objcurvature = CSIP_CURVATURE_UNKNOWN;
+    model->assumeconvexset = FALSE;
+    model->userassumeconvex = FALSE;
 
     model->nlazycb = 0;
     model->nheur = 0;
     model->initialsol = NULL;
+    model->repairbudget = 0.0;
+    model->initialsolstatus = CSIP_INITSOL_NONE;
     model->objvar = NULL;
     model->objcons = NULL;
     model->objtype = CSIP_OBJTYPE_LINEAR;
     model->msghdlr = NULL;
-
+    model->benders = NULL;
+    model->recording = NULL;
+    model->replay = NULL;
+    model->workercpus.nsets = 0;
+    model->hasexecutor = FALSE;
+    model->workercpus.beg = NULL;
+    model->workercpus.cpus = NULL;
+    model->deterministic = FALSE;
+    resetModelMetrics(model);
+    model->ntemplates = 0;
+    model->templatessize = 0;
+    model->templates = NULL;
+    model->nbasevalues = 0;
+    model->basevalues = NULL;
+    model->basetolerance = -1.0;
+    model->ngradevals = 0;
+    model->gradevals = NULL;
+    model->objgradeval.tree = NULL;
+    model->exprint = NULL;
+    model->nvarindex = 0;
+    model->varindex = NULL;
+    pthread_mutex_init(&model->progresslock, NULL);
+    resetProgress(model);
+
+    CSIP_CALL(includeProgressEventhdlr(model));
     CSIP_CALL(CSIPsetIntParam(model, "display/width", 80));
 
     return CSIP_RETCODE_OK;
@@ -447,10 +1146,51 @@ CSIP_RETCODE CSIPfreeModel(CSIP_MODEL *model)
         SCIP_in_CSIP(SCIPreleaseVar(model->scip, &model->objvar));
         SCIP_in_CSIP(SCIPreleaseCons(model->scip, &model->objcons));
     }
+    for (i = 0; i < model->ngradevals; ++i)
+    {
+        CSIP_CALL(freeGradEval(&model->gradevals[i]));
+    }
+    CSIP_CALL(freeGradEval(&model->objgradeval));
+    if (model->exprint != NULL)
+    {
+        SCIP_in_CSIP(SCIPexprintFree(&model->exprint));
+    }
+    if (model->varindex != NULL)
+    {
+        SCIPhashmapFree(&model->varindex);
+    }
     SCIP_in_CSIP(SCIPfree(&model->scip));
 
-    free(model->conss);
-    free(model->vars);
+    if (model->benders != NULL)
+    {
+        freeBenders(model->benders);
+    }
+    if (model->recording != NULL)
+    {
+        fclose(model->recording);
+    }
+    if (model->replay != NULL)
+    {
+        freeReplay(model->replay);
+    }
+    for (i = 0; i < model->ntemplates; ++i)
+    {
+        free(model->templates[i].ops);
+        free(model->templates[i].children);
+        free(model->templates[i].begin);
+        free(model->templates[i].values);
+    }
+    free(model->templates);
+    free(model->gradevals);
+    free(model->basevalues);
+    free(model->workercpus.beg);
+    free(model->workercpus.cpus);
+    pthread_mutex_destroy(&model->progresslock);
+    free(model->conscurvature);
+    free(model->conss);
+    free(model->inobjsupport);
+    free(model->objsupport);
+    free(model->vars);
     free(model);
 
     return CSIP_RETCODE_OK;
@@ -462,8 +1202,17 @@ CSIP_RETCODE CSIPaddVar(CSIP_MODEL *model, double lowerbound, double upperbound,
     SCIP *scip;
     SCIP_VAR *var;
 
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDVAR);
+        recordDouble(model, lowerbound);
+        recordDouble(model, upperbound);
+        recordInt(model, vartype);
+        recordEnd(model);
+    }
+
     scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    CSIP_CALL(freeTransform(model));
 
     SCIP_in_CSIP(SCIPcreateVarBasic(scip, &var, NULL, lowerbound, upperbound, 0.0,
                                     vartype));
@@ -475,7 +1224,12 @@ CSIP_RETCODE CSIPaddVar(CSIP_MODEL *model, double lowerbound, double upperbound,
         model->varssize = GROWFACTOR * model->varssize;
         model->vars = (SCIP_VAR **) realloc(
                           model->vars,  model->varssize * sizeof(SCIP_VAR *));
-        if (model->vars == NULL)
+        model->objsupport = (int *) realloc(
+                                model->objsupport, model->varssize * sizeof(int));
+        model->inobjsupport = (SCIP_Bool *) realloc(
+                                  model->inobjsupport, model->varssize * sizeof(SCIP_Bool));
+        if (model->vars == NULL || model->objsupport == NULL
+                || model->inobjsupport == NULL)
         {
             return CSIP_RETCODE_NOMEMORY;
         }
@@ -490,6 +1244,7 @@ CSIP_RETCODE CSIPaddVar(CSIP_MODEL *model, double lowerbound, double upperbound,
     {
         model->vars[model->nvars] = var;
     }
+    model->inobjsupport[model->nvars] = FALSE;
     ++(model->nvars);
 
     return CSIP_RETCODE_OK;
@@ -502,8 +1257,16 @@ CSIP_RETCODE CSIPchgVarLB(CSIP_MODEL *model, int numindices, int *indices,
     SCIP *scip;
     SCIP_VAR *var;
 
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_CHGVARLB);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, lowerbounds);
+        recordEnd(model);
+    }
+
     scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    CSIP_CALL(freeTransform(model));
 
     for (i = 0; i < numindices; ++i)
     {
@@ -521,8 +1284,16 @@ CSIP_RETCODE CSIPchgVarUB(CSIP_MODEL *model, int numindices, int *indices,
     SCIP *scip;
     SCIP_VAR *var;
 
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_CHGVARUB);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, upperbounds);
+        recordEnd(model);
+    }
+
     scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    CSIP_CALL(freeTransform(model));
 
     for (i = 0; i < numindices; ++i)
     {
@@ -540,7 +1311,15 @@ CSIP_RETCODE CSIPchgVarType(
     SCIP_VAR *var = model->vars[varindex];
     SCIP_Bool infeas = FALSE;
 
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_CHGVARTYPE);
+        recordInt(model, varindex);
+        recordInt(model, vartype);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
 
     SCIP_in_CSIP(SCIPchgVarType(scip, var, vartype, &infeas));
     // TODO: don't ignore `infeas`?
@@ -582,7 +1361,17 @@ CSIP_RETCODE CSIPaddLinCons(CSIP_MODEL *model, int numindices, int *indices,
 {
     SCIP_CONS *cons;
 
-    SCIP_in_CSIP(SCIPfreeTransform(model->scip));
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDLINCONS);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, coefs);
+        recordDouble(model, lhs);
+        recordDouble(model, rhs);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
 
     CSIP_CALL(createLinCons(model, numindices, indices, coefs, lhs, rhs, &cons));
     CSIP_CALL(addCons(model, cons, idx));
@@ -603,8 +1392,21 @@ CSIP_RETCODE CSIPaddQuadCons(CSIP_MODEL *model, int numlinindices,
     SCIP_VAR *var2;
     SCIP_CONS *cons;
 
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDQUADCONS);
+        recordInts(model, numlinindices, linindices);
+        recordDoubles(model, numlinindices, lincoefs);
+        recordInts(model, numquadterms, quadrowindices);
+        recordInts(model, numquadterms, quadcolindices);
+        recordDoubles(model, numquadterms, quadcoefs);
+        recordDouble(model, lhs);
+        recordDouble(model, rhs);
+        recordEnd(model);
+    }
+
     scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    CSIP_CALL(freeTransform(model));
 
     SCIP_in_CSIP(SCIPcreateConsBasicQuadratic(scip, &cons, "quadcons", 0, NULL,
                  NULL, 0, NULL, NULL, NULL, lhs, rhs));
@@ -627,6 +1429,270 @@ CSIP_RETCODE CSIPaddQuadCons(CSIP_MODEL *model, int numlinindices,
     return CSIP_RETCODE_OK;
 }
 
+// quadratic term of a constraint, with var1 <= var2
+struct quad_term
+{
+    int cons;
+    int var1;
+    int var2;
+    double coef;
+};
+
+static
+int compareQuadTerms(const void *a, const void *b)
+{
+    const struct quad_term *t1 = (const struct quad_term *) a;
+    const struct quad_term *t2 = (const struct quad_term *) b;
+
+    if (t1->cons != t2->cons)
+    {
+        return t1->cons < t2->cons ? -1 : 1;
+    }
+    if (t1->var1 != t2->var1)
+    {
+        return t1->var1 < t2->var1 ? -1 : 1;
+    }
+    if (t1->var2 != t2->var2)
+    {
+        return t1->var2 < t2->var2 ? -1 : 1;
+    }
+    return 0;
+}
+
+CSIP_RETCODE CSIPaddQuadConss(
+    CSIP_MODEL *model, int ncons, int *linbeg, int *linindices,
+    double *lincoefs, int numquadterms, int *quadconsindices,
+    int *quadrowindices, int *quadcolindices, double *quadcoefs, double *lhs,
+    double *rhs, int *idx)
+{
+    SCIP *scip = model->scip;
+    struct quad_term *terms;
+    SCIP_VAR **linvars;
+    SCIP_VAR **quadvars1;
+    SCIP_VAR **quadvars2;
+    double *coefs;
+    int maxlin = 0;
+    int nterms = 0;
+    int t = 0;
+    int c;
+    int i;
+
+    // linear parts in CSR format, over existing variables
+    if (ncons < 0 || linbeg[0] != 0)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    for (c = 0; c < ncons; ++c)
+    {
+        if (linbeg[c + 1] < linbeg[c])
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+    for (i = 0; i < linbeg[ncons]; ++i)
+    {
+        if (linindices[i] < 0 || linindices[i] >= model->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    // terms of constraints that don't exist would be dropped silently
+    for (i = 0; i < numquadterms; ++i)
+    {
+        if (quadconsindices[i] < 0 || quadconsindices[i] >= ncons
+                || quadrowindices[i] < 0 || quadrowindices[i] >= model->nvars
+                || quadcolindices[i] < 0 || quadcolindices[i] >= model->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDQUADCONSS);
+        recordInts(model, ncons + 1, linbeg);
+        recordInts(model, linbeg[ncons], linindices);
+        recordDoubles(model, linbeg[ncons], lincoefs);
+        recordInts(model, numquadterms, quadconsindices);
+        recordInts(model, numquadterms, quadrowindices);
+        recordInts(model, numquadterms, quadcolindices);
+        recordDoubles(model, numquadterms, quadcoefs);
+        recordDoubles(model, ncons, lhs);
+        recordDoubles(model, ncons, rhs);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    // sort terms by constraint and (unordered) variable pair, then merge
+    terms = (struct quad_term *) malloc(MAX(1, numquadterms) * sizeof(
+                                            struct quad_term));
+    if (terms == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (i = 0; i < numquadterms; ++i)
+    {
+        terms[i].cons = quadconsindices[i];
+        terms[i].var1 = MIN(quadrowindices[i], quadcolindices[i]);
+        terms[i].var2 = MAX(quadrowindices[i], quadcolindices[i]);
+        terms[i].coef = quadcoefs[i];
+    }
+    qsort(terms, numquadterms, sizeof(struct quad_term), compareQuadTerms);
+    for (i = 0; i < numquadterms; ++i)
+    {
+        if (nterms > 0 && compareQuadTerms(&terms[nterms - 1], &terms[i]) == 0)
+        {
+            terms[nterms - 1].coef += terms[i].coef;
+        }
+        else
+        {
+            terms[nterms] = terms[i];
+            ++nterms;
+        }
+    }
+
+    // buffers are shared by all constraints
+    for (c = 0; c < ncons; ++c)
+    {
+        maxlin = MAX(maxlin, linbeg[c + 1] - linbeg[c]);
+    }
+    linvars = (SCIP_VAR **) malloc(MAX(1, maxlin) * sizeof(SCIP_VAR *));
+    quadvars1 = (SCIP_VAR **) malloc(MAX(1, nterms) * sizeof(SCIP_VAR *));
+    quadvars2 = (SCIP_VAR **) malloc(MAX(1, nterms) * sizeof(SCIP_VAR *));
+    coefs = (double *) malloc(MAX(1, nterms) * sizeof(double));
+    if (linvars == NULL || quadvars1 == NULL || quadvars2 == NULL
+            || coefs == NULL)
+    {
+        free(coefs);
+        free(quadvars2);
+        free(quadvars1);
+        free(linvars);
+        free(terms);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    for (c = 0; c < ncons; ++c)
+    {
+        SCIP_CONS *cons;
+        int nquad = 0;
+        int nlin = linbeg[c + 1] - linbeg[c];
+
+        for (i = 0; i < nlin; ++i)
+        {
+            linvars[i] = model->vars[linindices[linbeg[c] + i]];
+        }
+        for (; t < nterms && terms[t].cons == c; ++t)
+        {
+            if (terms[t].coef != 0.0)
+            {
+                quadvars1[nquad] = model->vars[terms[t].var1];
+                quadvars2[nquad] = model->vars[terms[t].var2];
+                coefs[nquad] = terms[t].coef;
+                ++nquad;
+            }
+        }
+
+        SCIP_in_CSIP(SCIPcreateConsBasicQuadratic(scip, &cons, "quadcons", nlin,
+                     linvars, &lincoefs[linbeg[c]], nquad, quadvars1, quadvars2,
+                     coefs, lhs[c], rhs[c]));
+        CSIP_CALL(addCons(model, cons, (c == 0) ? idx : NULL));
+    }
+
+    free(coefs);
+    free(quadvars2);
+    free(quadvars1);
+    free(linvars);
+    free(terms);
+
+    return CSIP_RETCODE_OK;
+}
+
+/* checks that ops form a valid expression: children of ops precede them and
+ * each op has as many children as createExprtree expects; begin may point
+ * into a larger array, so begin[0] need not be 0 */
+static
+CSIP_RETCODE checkExpr(int nops, CSIP_OP *ops, int *children, int *begin,
+                       int nvars)
+{
+    int i;
+
+    if (nops < 1)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    for (i = 0; i < nops; ++i)
+    {
+        int nchildren = begin[i + 1] - begin[i];
+        int c;
+
+        switch (ops[i])
+        {
+        case VARIDX:
+            if (nchildren != 1 || children[begin[i]] < 0
+                    || children[begin[i]] >= nvars)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            continue;
+        case CONST:
+            if (nchildren != 1 || children[begin[i]] < 0)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            continue;
+        case MINUS:
+            if (nchildren != 1 && nchildren != 2)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            break;
+        case POW:
+            if (nchildren != 2 || children[begin[i] + 1] < 0
+                    || children[begin[i] + 1] >= i
+                    || ops[children[begin[i] + 1]] != CONST)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            break;
+        case DIV:
+            if (nchildren != 2)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            break;
+        case OPSQRT:
+        case EXP:
+        case LOG:
+            if (nchildren != 1)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            break;
+        case SUM:
+        case PROD:
+            if (nchildren < 1)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+            break;
+        default:
+            return CSIP_RETCODE_ERROR;
+        }
+
+        for (c = begin[i]; c < begin[i + 1]; ++c)
+        {
+            if (children[c] < 0 || children[c] >= i)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+        }
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
 // we might be assuming that the indices of the children of op[k]
 // are always <= k (when op[k] is not VARIDX nor CONST)
 // this implies that the root expression is the last one, which is
@@ -639,11 +1705,20 @@ CSIP_RETCODE CSIPaddNonLinCons(
     SCIP_EXPRTREE *tree;
     SCIP_CONS *cons;
 
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDNONLINCONS);
+        recordExpr(model, nops, ops, children, begin, values);
+        recordDouble(model, lhs);
+        recordDouble(model, rhs);
+        recordEnd(model);
+    }
+
     CSIP_CALL(createExprtree(model, nops, ops, children, begin,
                              values, &tree));
 
     scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    CSIP_CALL(freeTransform(model));
 
     // create nonlinear constraint
     SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(scip, &cons, "nonlin", 0, NULL, NULL,
@@ -657,990 +1732,4859 @@ CSIP_RETCODE CSIPaddNonLinCons(
     return CSIP_RETCODE_OK;
 }
 
-CSIP_RETCODE CSIPaddSOS1(
-    CSIP_MODEL *model, int numindices, int *indices, double *weights, int *idx)
+CSIP_RETCODE CSIPaddNonLinConss(
+    CSIP_MODEL *model, int ncons, int *consbeg, CSIP_OP *ops, int *children,
+    int *begin, double *values, double *lhs, double *rhs, int *idx)
 {
     SCIP *scip = model->scip;
-    SCIP_CONS *cons;
-    SCIP_VAR **vars = (SCIP_VAR **) malloc(numindices * sizeof(SCIP_VAR *));
+    SCIP_EXPR **exprs;
+    SCIP_EXPR **childexprs;
+    SCIP_VAR **vars;
+    int maxops = 0;
+    int c;
+
+    // every expression is checked before any is built
+    if (ncons < 0 || consbeg[0] != 0 || begin[0] != 0)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    for (c = 0; c < ncons; ++c)
+    {
+        int first = consbeg[c];
+
+        if (consbeg[c + 1] < first
+                || checkExpr(consbeg[c + 1] - first, &ops[first], children,
+                             &begin[first], model->nvars) != CSIP_RETCODE_OK)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
 
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDNONLINCONSS);
+        recordExpr(model, consbeg[ncons], ops, children, begin, values);
+        recordInts(model, ncons + 1, consbeg);
+        recordDoubles(model, ncons, lhs);
+        recordDoubles(model, ncons, rhs);
+        recordEnd(model);
+    }
 
-    if (vars == NULL)
+    CSIP_CALL(freeTransform(model));
+
+    // scratch space is shared by all constraints
+    for (c = 0; c < ncons; ++c)
     {
-        return CSIP_RETCODE_NOMEMORY;
+        maxops = MAX(maxops, consbeg[c + 1] - consbeg[c]);
     }
-    for (int i = 0; i < numindices; ++i)
+    exprs = (SCIP_EXPR **) malloc(MAX(1, maxops) * sizeof(SCIP_EXPR *));
+    vars = (SCIP_VAR **) malloc(MAX(1, maxops) * sizeof(SCIP_VAR *));
+    childexprs = (SCIP_EXPR **) malloc(
+                     MAX(1, maxNumChildren(consbeg[ncons], begin)) * sizeof(SCIP_EXPR *));
+    if (exprs == NULL || vars == NULL || childexprs == NULL)
     {
-        vars[i] = model->vars[indices[i]];
+        free(childexprs);
+        free(vars);
+        free(exprs);
+        return CSIP_RETCODE_NOMEMORY;
     }
 
-    SCIP_in_CSIP(SCIPcreateConsBasicSOS1(
-                     scip, &cons, "sos1", numindices, vars, weights));
-    CSIP_CALL(addCons(model, cons, idx));
+    for (c = 0; c < ncons; ++c)
+    {
+        SCIP_EXPRTREE *tree;
+        SCIP_CONS *cons;
+        int first = consbeg[c];
+
+        // op children are local to the constraint, begin is global
+        CSIP_CALL(buildExprtree(model, consbeg[c + 1] - first, &ops[first],
+                                children, &begin[first], values, model->vars,
+                                exprs, vars, childexprs, &tree));
+
+        SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(scip, &cons, "nonlin", 0, NULL,
+                     NULL, 1, &tree, NULL, lhs[c], rhs[c]));
+        CSIP_CALL(addCons(model, cons, (c == 0) ? idx : NULL));
+
+        SCIP_in_CSIP(SCIPexprtreeFree(&tree));
+    }
 
+    free(childexprs);
     free(vars);
+    free(exprs);
 
     return CSIP_RETCODE_OK;
 }
 
-CSIP_RETCODE CSIPaddSOS2(
-    CSIP_MODEL *model, int numindices, int *indices, double *weights, int *idx)
+CSIP_RETCODE CSIPregisterExprTemplate(
+    CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
+    double *values, int nslots, int *tid)
 {
-    SCIP *scip = model->scip;
-    SCIP_CONS *cons;
-    SCIP_VAR **vars = (SCIP_VAR **) malloc(numindices * sizeof(SCIP_VAR *));
+    struct expr_template *tmpl;
+    int nchildren;
 
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    if (begin[0] != 0
+            || checkExpr(nops, ops, children, begin, nslots) != CSIP_RETCODE_OK)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
 
-    if (vars == NULL)
+    if (model->recording != NULL)
     {
-        return CSIP_RETCODE_NOMEMORY;
+        recordOp(model, RECORD_REGISTEREXPRTEMPLATE);
+        recordExpr(model, nops, ops, children, begin, values);
+        recordInt(model, nslots);
+        recordEnd(model);
     }
-    for (int i = 0; i < numindices; ++i)
+
+    // do we need to resize?
+    if (model->ntemplates >= model->templatessize)
     {
-        vars[i] = model->vars[indices[i]];
+        model->templatessize = MAX(INITIALSIZE,
+                                   GROWFACTOR * model->templatessize);
+        model->templates = (struct expr_template *) realloc(model->templates,
+                           model->templatessize * sizeof(struct expr_template));
+        if (model->templates == NULL)
+        {
+            return CSIP_RETCODE_NOMEMORY;
+        }
     }
 
-    SCIP_in_CSIP(SCIPcreateConsBasicSOS2(
-                     scip, &cons, "sos2", numindices, vars, weights));
-    CSIP_CALL(addCons(model, cons, idx));
+    nchildren = begin[nops];
+    tmpl = &model->templates[model->ntemplates];
+    tmpl->nops = nops;
+    tmpl->nslots = nslots;
+    tmpl->nvalues = exprNumValues(nops, ops, children, begin);
+    tmpl->maxchildren = maxNumChildren(nops, begin);
+    tmpl->ops = (CSIP_OP *) malloc(nops * sizeof(CSIP_OP));
+    tmpl->children = (int *) malloc(nchildren * sizeof(int));
+    tmpl->begin = (int *) malloc((nops + 1) * sizeof(int));
+    tmpl->values = (double *) malloc(MAX(1, tmpl->nvalues)
+                                         * sizeof(double));
+    if (tmpl->ops == NULL || tmpl->children == NULL
+            || tmpl->begin == NULL || tmpl->values == NULL)
+    {
+        // the slot is not counted, the next registration reuses it
+        free(tmpl->values);
+        free(tmpl->begin);
+        free(tmpl->children);
+        free(tmpl->ops);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    memcpy(tmpl->ops, ops, nops * sizeof(CSIP_OP));
+    memcpy(tmpl->children, children, nchildren * sizeof(int));
+    memcpy(tmpl->begin, begin, (nops + 1) * sizeof(int));
+    if (tmpl->nvalues > 0)
+    {
+        memcpy(tmpl->values, values, tmpl->nvalues * sizeof(double));
+    }
 
-    free(vars);
+    if (tid != NULL)
+    {
+        *tid = model->ntemplates;
+    }
+    ++(model->ntemplates);
 
     return CSIP_RETCODE_OK;
 }
 
-CSIP_RETCODE CSIPsetObj(CSIP_MODEL *model, int numindices, int *indices,
-                        double *coefs)
+CSIP_RETCODE CSIPaddNonLinConsFromTemplate(
+    CSIP_MODEL *model, int tid, int ninst, int *slotvars, double *constants,
+    double *lhs, double *rhs, int *idx)
 {
-    int i;
-    SCIP *scip;
-    SCIP_VAR *var;
+    SCIP *scip = model->scip;
+    struct expr_template *tmpl;
+    SCIP_EXPR **exprs;
+    SCIP_EXPR **childexprs;
+    SCIP_VAR **vars;
+    SCIP_VAR **slotmap;
+    int k;
 
-    scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+    if (tid < 0 || tid >= model->ntemplates)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    tmpl = &model->templates[tid];
 
-    for (i = 0; i < numindices; ++i)
+    for (k = 0; k < ninst * tmpl->nslots; ++k)
     {
-        var = model->vars[indices[i]];
-        SCIP_in_CSIP(SCIPchgVarObj(scip, var, coefs[i]));
+        if (slotvars[k] < 0 || slotvars[k] >= model->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
     }
-    model->objtype = CSIP_OBJTYPE_LINEAR;
 
-    // if nonlinear objective was set, remove objvar from objective
-    // and relax its bounds. This should render the objective constraint
-    // redundant
-    if (model->objvar != NULL)
+    if (model->recording != NULL)
     {
-        SCIP_in_CSIP(SCIPchgVarObj(scip, model->objvar, 0.0));
-        SCIP_in_CSIP(SCIPchgVarLb(scip, model->objvar, -SCIPinfinity(scip)));
-        SCIP_in_CSIP(SCIPchgVarUb(scip, model->objvar, SCIPinfinity(scip)));
+        recordOp(model, RECORD_ADDNONLINCONSFROMTEMPLATE);
+        recordInt(model, tid);
+        recordInt(model, ninst);
+        recordInts(model, ninst * tmpl->nslots, slotvars);
+        recordDoubles(model, ninst * tmpl->nvalues, constants);
+        recordDoubles(model, ninst, lhs);
+        recordDoubles(model, ninst, rhs);
+        recordEnd(model);
+    }
 
-        // we do not need to remember this variable anymore nor the objcons
-        SCIP_in_CSIP(SCIPreleaseVar(scip, &model->objvar));
-        SCIP_in_CSIP(SCIPreleaseCons(scip, &model->objcons));
-        assert(model->objvar == NULL);
-        assert(model->objcons == NULL);
+    CSIP_CALL(freeTransform(model));
+
+    exprs = (SCIP_EXPR **) malloc(tmpl->nops * sizeof(SCIP_EXPR *));
+    vars = (SCIP_VAR **) malloc(tmpl->nops * sizeof(SCIP_VAR *));
+    childexprs = (SCIP_EXPR **) malloc(MAX(1, tmpl->maxchildren)
+                                       * sizeof(SCIP_EXPR *));
+    slotmap = (SCIP_VAR **) malloc(MAX(1, tmpl->nslots)
+                                   * sizeof(SCIP_VAR *));
+    if (exprs == NULL || vars == NULL || childexprs == NULL || slotmap == NULL)
+    {
+        free(slotmap);
+        free(childexprs);
+        free(vars);
+        free(exprs);
+        return CSIP_RETCODE_NOMEMORY;
     }
 
-    return CSIP_RETCODE_OK;
-}
+    for (int inst = 0; inst < ninst; ++inst)
+    {
+        SCIP_EXPRTREE *tree;
+        SCIP_CONS *cons;
+        double *values = tmpl->values;
 
-CSIP_RETCODE CSIPsetQuadObj(CSIP_MODEL *model, int numlinindices,
-                            int *linindices, double *lincoefs, int numquadterms,
-                            int *quadrowindices, int *quadcolindices,
-                            double *quadcoefs)
+        for (k = 0; k < tmpl->nslots; ++k)
+        {
+            slotmap[k] = model->vars[slotvars[inst * tmpl->nslots + k]];
+        }
+        if (constants != NULL)
+        {
+            values = &constants[inst * tmpl->nvalues];
+        }
+
+        CSIP_CALL(buildExprtree(model, tmpl->nops, tmpl->ops,
+                                tmpl->children, tmpl->begin, values,
+                                slotmap, exprs, vars, childexprs, &tree));
+
+        SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(scip, &cons, "nonlin", 0, NULL,
+                     NULL, 1, &tree, NULL, lhs[inst], rhs[inst]));
+        CSIP_CALL(addCons(model, cons, (inst == 0) ? idx : NULL));
+
+        SCIP_in_CSIP(SCIPexprtreeFree(&tree));
+    }
+
+    free(slotmap);
+    free(childexprs);
+    free(vars);
+    free(exprs);
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPaddSOS1(
+    CSIP_MODEL *model, int numindices, int *indices, double *weights, int *idx)
 {
-    int nprods;
-    int i;
-    int opidx;
-    int nops;
-    int nchildren;
-    CSIP_OP *ops;
-    int *children;
-    int *begin;
-    int *prodindices;
-    double *values;
+    SCIP *scip = model->scip;
+    SCIP_CONS *cons;
+    SCIP_VAR **vars = (SCIP_VAR **) malloc(numindices * sizeof(SCIP_VAR *));
 
-    // build the expression representation of a quadratic
-    // there are: numlinindices VARIDX, CONST and PROD for the linear part
-    // nquadterms VARIDX, VARIDX, CONST and PROD for the quadratic part
-    // So there are 3*numlindices + 4*nquadterms operators plus 1 (the sum)
-    // Number of children: each VARIDX and CONST contribute with one:
-    // nchildren >= 2*numlinindices + 3*nquadterms
-    // Then each PROD in numlinindices contribute with 2 and in nquadterms with 3
-    // nchildren >= 4*numlinindices + 6*nquadterms
-    // The final sum has as many children as products are there, nlinind + nquadterms
-    // nchildren = 5*numlinindices + 7*nquadterms
-    // NOTE: we will need to store the indices of the PROD operators
-    //       and all coefs in a single array `values`
-    nprods = numquadterms + numlinindices;
-    nchildren = 5 * numlinindices + 7 * numquadterms;
-    nops = 3 * numlinindices + 4 * numquadterms + 1;
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDSOS1);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, weights);
+        recordEnd(model);
+    }
 
-    ops = (int *) malloc(nops * sizeof(CSIP_OP));
-    children = (int *) malloc(nchildren * sizeof(int));
-    begin = (int *) malloc((nops + 1) * sizeof(int));
-    values = (double *) malloc(nprods * sizeof(double));
-    prodindices = (int *) malloc(nprods * sizeof(int));
+    CSIP_CALL(freeTransform(model));
 
-    begin[0] = 0;
-    opidx = -1;
-    // linear part
-    for (i = 0; i < numlinindices; ++i)
+    if (vars == NULL)
     {
-        // variable
-        ++opidx;
-        ops[opidx] = VARIDX;
-        begin[opidx + 1] = begin[opidx] + 1; // where its children end
-        children[begin[opidx]] = linindices[i]; //children
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (int i = 0; i < numindices; ++i)
+    {
+        vars[i] = model->vars[indices[i]];
+    }
 
-        // next operator: coef
-        ++opidx;
-        ops[opidx] = CONST;
-        begin[opidx + 1] = begin[opidx] + 1;
-        children[begin[opidx]] = i;
-        values[i] = lincoefs[i];
+    SCIP_in_CSIP(SCIPcreateConsBasicSOS1(
+                     scip, &cons, "sos1", numindices, vars, weights));
+    CSIP_CALL(addCons(model, cons, idx));
 
-        // next operator: PROD between coef and variable
-        ++opidx;
-        ops[opidx] = PROD;
-        begin[opidx + 1] = begin[opidx] + 2;
-        children[begin[opidx]] = opidx - 2;
-        children[begin[opidx] + 1] = opidx - 1;
+    free(vars);
 
-        prodindices[i] = opidx;
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPaddSOS2(
+    CSIP_MODEL *model, int numindices, int *indices, double *weights, int *idx)
+{
+    SCIP *scip = model->scip;
+    SCIP_CONS *cons;
+    SCIP_VAR **vars = (SCIP_VAR **) malloc(numindices * sizeof(SCIP_VAR *));
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDSOS2);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, weights);
+        recordEnd(model);
     }
-    // quadratic part
-    for (i = 0; i < numquadterms; ++i)
+
+    CSIP_CALL(freeTransform(model));
+
+    if (vars == NULL)
     {
-        // variable 1
-        ++opidx;
-        ops[opidx] = VARIDX;
-        begin[opidx + 1] = begin[opidx] + 1; // where its children end
-        children[begin[opidx]] = quadrowindices[i]; //children
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (int i = 0; i < numindices; ++i)
+    {
+        vars[i] = model->vars[indices[i]];
+    }
 
-        // variable 2
-        ++opidx;
-        ops[opidx] = VARIDX;
-        begin[opidx + 1] = begin[opidx] + 1; // where its children end
-        children[begin[opidx]] = quadcolindices[i]; //children
+    SCIP_in_CSIP(SCIPcreateConsBasicSOS2(
+                     scip, &cons, "sos2", numindices, vars, weights));
+    CSIP_CALL(addCons(model, cons, idx));
 
-        // coef
-        ++opidx;
-        ops[opidx] = CONST;
-        begin[opidx + 1] = begin[opidx] + 1;
-        children[begin[opidx]] = i + numlinindices;
-        values[i + numlinindices] = quadcoefs[i];
+    free(vars);
 
-        // next operator: PROD between var1, var2 and coef
-        ++opidx;
-        ops[opidx] = PROD;
-        begin[opidx + 1] = begin[opidx] + 3;
-        children[begin[opidx]] = opidx - 3;
-        children[begin[opidx] + 1] = opidx - 2;
-        children[begin[opidx] + 2] = opidx - 1;
+    return CSIP_RETCODE_OK;
+}
 
-        prodindices[i + numlinindices] = opidx;
+CSIP_RETCODE CSIPaddSOSBatch(
+    CSIP_MODEL *model, CSIP_SOSTYPE type, int nsets, int *setbeg, int *indices,
+    double *weights, int *idx)
+{
+    SCIP *scip = model->scip;
+    SCIP_VAR **vars;
+    int maxsize = 0;
+    int s;
+
+    if (type != CSIP_SOSTYPE_SOS1 && type != CSIP_SOSTYPE_SOS2)
+    {
+        return CSIP_RETCODE_ERROR;
     }
 
-    // sum all PRODs
-    ++opidx;
-    ops[opidx] = SUM;
-    begin[opidx + 1] = begin[opidx] + nprods;
-    for (i = 0; i < nprods; ++i)
+    if (model->recording != NULL)
     {
-        children[begin[opidx] + i] = prodindices[i];
+        recordOp(model, RECORD_ADDSOSBATCH);
+        recordInt(model, type);
+        recordInts(model, nsets + 1, setbeg);
+        recordInts(model, setbeg[nsets], indices);
+        recordDoubles(model, setbeg[nsets], weights);
+        recordEnd(model);
     }
 
-    CSIP_CALL(CSIPsetNonlinearObj(model, nops, ops, children, begin, values));
+    CSIP_CALL(freeTransform(model));
 
-    // free everything
-    free(ops);
-    free(children);
-    free(begin);
-    free(values);
-    free(prodindices);
+    // one buffer, large enough for every set
+    for (s = 0; s < nsets; ++s)
+    {
+        maxsize = MAX(maxsize, setbeg[s + 1] - setbeg[s]);
+    }
+    vars = (SCIP_VAR **) malloc(MAX(1, maxsize) * sizeof(SCIP_VAR *));
+    if (vars == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    for (s = 0; s < nsets; ++s)
+    {
+        SCIP_CONS *cons;
+        double *setweights = (weights == NULL) ? NULL : &weights[setbeg[s]];
+        int size = setbeg[s + 1] - setbeg[s];
+
+        for (int i = 0; i < size; ++i)
+        {
+            vars[i] = model->vars[indices[setbeg[s] + i]];
+        }
+
+        if (type == CSIP_SOSTYPE_SOS1)
+        {
+            SCIP_in_CSIP(SCIPcreateConsBasicSOS1(
+                             scip, &cons, "sos1", size, vars, setweights));
+        }
+        else
+        {
+            SCIP_in_CSIP(SCIPcreateConsBasicSOS2(
+                             scip, &cons, "sos2", size, vars, setweights));
+        }
+        CSIP_CALL(addCons(model, cons, (s == 0) ? idx : NULL));
+    }
+
+    free(vars);
 
     return CSIP_RETCODE_OK;
 }
 
-CSIP_RETCODE CSIPsetNonlinearObj(
-    CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
-    double *values)
+/* checks an orbitope on varmatrix: distinct binary variables, at least two
+ * columns */
+static
+CSIP_RETCODE checkOrbitope(
+    CSIP_MODEL *model, int nrows, int ncols, int *varmatrix,
+    CSIP_ORBITOPETYPE type)
 {
-    SCIP *scip;
-    SCIP_EXPRTREE *tree;
+    SCIP_Bool *used;
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
+
+    if (nrows < 1 || ncols < 2 || (type != CSIP_ORBITOPETYPE_PACKING
+                                   && type != CSIP_ORBITOPETYPE_PARTITIONING))
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    used = (SCIP_Bool *) calloc(MAX(1, model->nvars), sizeof(SCIP_Bool));
+    if (used == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (int i = 0; i < nrows * ncols && retcode == CSIP_RETCODE_OK; ++i)
+    {
+        if (varmatrix[i] < 0 || varmatrix[i] >= model->nvars
+                || used[varmatrix[i]]
+                || SCIPvarGetType(model->vars[varmatrix[i]]) != SCIP_VARTYPE_BINARY)
+        {
+            retcode = CSIP_RETCODE_ERROR;
+        }
+        else
+        {
+            used[varmatrix[i]] = TRUE;
+        }
+    }
+    free(used);
+
+    return retcode;
+}
+
+/* adds orbitope on the binary variables varmatrix (row-major), whose columns
+ * are symmetric; arguments must have passed checkOrbitope */
+static
+CSIP_RETCODE addOrbitope(
+    CSIP_MODEL *model, int nrows, int ncols, int *varmatrix,
+    CSIP_ORBITOPETYPE type, int *idx)
+{
+    SCIP *scip = model->scip;
     SCIP_CONS *cons;
+    SCIP_VAR ***vars;
+    SCIP_VAR **entries;
+    int i;
 
-    CSIP_CALL(createExprtree(model, nops, ops, children, begin,
-                             values, &tree));
+    CSIP_CALL(freeTransform(model));
+
+    vars = (SCIP_VAR ***) malloc(nrows * sizeof(SCIP_VAR **));
+    entries = (SCIP_VAR **) malloc(nrows * ncols * sizeof(SCIP_VAR *));
+    if (vars == NULL || entries == NULL)
+    {
+        free(entries);
+        free(vars);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (i = 0; i < nrows * ncols; ++i)
+    {
+        entries[i] = model->vars[varmatrix[i]];
+    }
+    for (i = 0; i < nrows; ++i)
+    {
+        vars[i] = &entries[i * ncols];
+    }
+
+    SCIP_in_CSIP(SCIPcreateConsBasicOrbitope(scip, &cons, "orbitope", vars,
+                 (type == CSIP_ORBITOPETYPE_PACKING) ? SCIP_ORBITOPETYPE_PACKING :
+                 SCIP_ORBITOPETYPE_PARTITIONING, nrows, ncols, TRUE));
+    CSIP_CALL(addCons(model, cons, idx));
+
+    free(entries);
+    free(vars);
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPaddOrbitope(
+    CSIP_MODEL *model, int nrows, int ncols, int *varmatrix,
+    CSIP_ORBITOPETYPE type, int *idx)
+{
+    CSIP_RETCODE retcode = checkOrbitope(model, nrows, ncols, varmatrix, type);
+
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        return retcode;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDORBITOPE);
+        recordInt(model, nrows);
+        recordInt(model, ncols);
+        recordInts(model, nrows * ncols, varmatrix);
+        recordInt(model, type);
+        recordEnd(model);
+    }
+
+    return addOrbitope(model, nrows, ncols, varmatrix, type, idx);
+}
+
+CSIP_RETCODE CSIPaddSymmetricBlocks(
+    CSIP_MODEL *model, int nblocks, int blocksize, int *blockvars, int *idx)
+{
+    SCIP *scip = model->scip;
+    SCIP_HASHMAP *rowof;
+    CSIP_ORBITOPETYPE type = CSIP_ORBITOPETYPE_PARTITIONING;
+    SCIP_Bool complete = TRUE;
+    int *varmatrix;
+    int *rowtype; // 0: no row constraint, 1: packing, 2: partitioning
+    CSIP_RETCODE retcode;
+    int i;
+
+    // the orbitope has the same variables, as blocksize rows of nblocks
+    retcode = checkOrbitope(model, blocksize, nblocks, blockvars, type);
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        return retcode;
+    }
+
+    varmatrix = (int *) malloc(nblocks * blocksize * sizeof(int));
+    rowtype = (int *) calloc(blocksize, sizeof(int));
+    if (varmatrix == NULL || rowtype == NULL)
+    {
+        free(rowtype);
+        free(varmatrix);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    // row k of the orbitope holds the k-th variable of every block; the map
+    // stores k + 1, since absent variables are mapped to NULL
+    SCIP_in_CSIP(SCIPhashmapCreate(&rowof, SCIPblkmem(scip),
+                                   nblocks * blocksize + 1));
+    for (int b = 0; b < nblocks; ++b)
+    {
+        for (int k = 0; k < blocksize; ++k)
+        {
+            int varidx = blockvars[b * blocksize + k];
+            varmatrix[k * nblocks + b] = varidx;
+            SCIP_in_CSIP(SCIPhashmapInsert(rowof, model->vars[varidx],
+                                           (void *)(size_t)(k + 1)));
+        }
+    }
+
+    // find the set packing/partitioning rows among the linear constraints
+    for (i = 0; i < model->nconss; ++i)
+    {
+        SCIP_CONS *cons = model->conss[i];
+        SCIP_VAR **vars;
+        double *vals;
+        int row;
+
+        if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "linear") != 0
+                || SCIPgetNVarsLinear(scip, cons) != nblocks
+                || !SCIPisEQ(scip, SCIPgetRhsLinear(scip, cons), 1.0))
+        {
+            continue;
+        }
+        vars = SCIPgetVarsLinear(scip, cons);
+        vals = SCIPgetValsLinear(scip, cons);
+        row = (int)(size_t) SCIPhashmapGetImage(rowof, vars[0]) - 1;
+        for (int j = 0; j < nblocks && row >= 0; ++j)
+        {
+            if ((int)(size_t) SCIPhashmapGetImage(rowof, vars[j]) - 1 != row
+                    || !SCIPisEQ(scip, vals[j], 1.0))
+            {
+                row = -1;
+            }
+        }
+        if (row >= 0)
+        {
+            int thistype = SCIPisEQ(scip, SCIPgetLhsLinear(scip, cons), 1.0) ? 2 : 1;
+            rowtype[row] = MAX(rowtype[row], thistype);
+        }
+    }
+    for (int k = 0; k < blocksize; ++k)
+    {
+        complete = complete && (rowtype[k] > 0);
+        if (rowtype[k] == 1)
+        {
+            type = CSIP_ORBITOPETYPE_PACKING;
+        }
+    }
+
+    if (complete)
+    {
+        if (model->recording != NULL)
+        {
+            recordOp(model, RECORD_ADDSYMMETRICBLOCKS);
+            recordInt(model, nblocks);
+            recordInt(model, blocksize);
+            recordInts(model, nblocks * blocksize, blockvars);
+            recordEnd(model);
+        }
+        retcode = addOrbitope(model, blocksize, nblocks, varmatrix, type, idx);
+    }
+    else
+    {
+        retcode = CSIP_RETCODE_ERROR;
+    }
+
+    SCIPhashmapFree(&rowof);
+    free(rowtype);
+    free(varmatrix);
+
+    return retcode;
+}
+
+CSIP_RETCODE CSIPaddBoundDisjunction(
+    CSIP_MODEL *model, int n, int *indices, CSIP_BOUNDTYPE *boundtypes,
+    double *bounds, int *idx)
+{
+    SCIP *scip = model->scip;
+    SCIP_CONS *cons;
+    SCIP_VAR **vars;
+    SCIP_BOUNDTYPE *scipboundtypes;
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (indices[i] < 0 || indices[i] >= model->nvars
+                || (boundtypes[i] != CSIP_BOUNDTYPE_LOWER
+                    && boundtypes[i] != CSIP_BOUNDTYPE_UPPER))
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDBOUNDDISJUNCTION);
+        recordInts(model, n, indices);
+        recordInts(model, n, boundtypes);
+        recordDoubles(model, n, bounds);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    vars = (SCIP_VAR **) malloc(MAX(1, n) * sizeof(SCIP_VAR *));
+    scipboundtypes = (SCIP_BOUNDTYPE *) malloc(MAX(1, n) * sizeof(SCIP_BOUNDTYPE));
+    if (vars == NULL || scipboundtypes == NULL)
+    {
+        free(scipboundtypes);
+        free(vars);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        vars[i] = model->vars[indices[i]];
+        scipboundtypes[i] = (boundtypes[i] == CSIP_BOUNDTYPE_LOWER) ?
+                            SCIP_BOUNDTYPE_LOWER : SCIP_BOUNDTYPE_UPPER;
+    }
+
+    SCIP_in_CSIP(SCIPcreateConsBasicBounddisjunction(scip, &cons,
+                 "bounddisjunction", n, vars, scipboundtypes, bounds));
+    CSIP_CALL(addCons(model, cons, idx));
+
+    free(scipboundtypes);
+    free(vars);
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPaddCumulative(
+    CSIP_MODEL *model, int njobs, int *startvars, int *durations, int *demands,
+    int capacity, int *idx)
+{
+    SCIP *scip = model->scip;
+    SCIP_CONS *cons;
+    SCIP_VAR **vars;
+
+    if (capacity < 0)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    // start times must be integer
+    for (int j = 0; j < njobs; ++j)
+    {
+        if (startvars[j] < 0 || startvars[j] >= model->nvars
+                || SCIPvarGetType(model->vars[startvars[j]]) == SCIP_VARTYPE_CONTINUOUS
+                || durations[j] < 0 || demands[j] < 0)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDCUMULATIVE);
+        recordInts(model, njobs, startvars);
+        recordInts(model, njobs, durations);
+        recordInts(model, njobs, demands);
+        recordInt(model, capacity);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    vars = (SCIP_VAR **) malloc(MAX(1, njobs) * sizeof(SCIP_VAR *));
+    if (vars == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (int j = 0; j < njobs; ++j)
+    {
+        vars[j] = model->vars[startvars[j]];
+    }
+
+    SCIP_in_CSIP(SCIPcreateConsBasicCumulative(scip, &cons, "cumulative", njobs,
+                 vars, durations, demands, capacity));
+    CSIP_CALL(addCons(model, cons, idx));
+
+    free(vars);
+
+    return CSIP_RETCODE_OK;
+}
+
+static
+CSIP_RETCODE setObj(CSIP_MODEL *model, int numindices, int *indices,
+                    double *coefs)
+{
+    int i;
+    SCIP *scip;
+
+    scip = model->scip;
+    CSIP_CALL(freeTransform(model));
+
+    for (i = 0; i < numindices; ++i)
+    {
+        CSIP_CALL(setVarObj(model, indices[i], coefs[i]));
+    }
+    model->objtype = CSIP_OBJTYPE_LINEAR;
+
+    // if nonlinear objective was set, remove objvar from objective
+    // and relax its bounds. This should render the objective constraint
+    // redundant
+    if (model->objvar != NULL)
+    {
+        SCIP_in_CSIP(SCIPchgVarObj(scip, model->objvar, 0.0));
+        SCIP_in_CSIP(SCIPchgVarLb(scip, model->objvar, -SCIPinfinity(scip)));
+        SCIP_in_CSIP(SCIPchgVarUb(scip, model->objvar, SCIPinfinity(scip)));
+
+        // we do not need to remember this variable anymore nor the objcons
+        SCIP_in_CSIP(SCIPreleaseVar(scip, &model->objvar));
+        SCIP_in_CSIP(SCIPreleaseCons(scip, &model->objcons));
+        assert(model->objvar == NULL);
+        assert(model->objcons == NULL);
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetObj(CSIP_MODEL *model, int numindices, int *indices,
+                        double *coefs)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETOBJ);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, coefs);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(setObj(model, numindices, indices, coefs));
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPreplaceObj(CSIP_MODEL *model, int numindices, int *indices,
+                            double *coefs)
+{
+    int i;
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_REPLACEOBJ);
+        recordInts(model, numindices, indices);
+        recordDoubles(model, numindices, coefs);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    // clear previous objective
+    for (i = 0; i < model->nobjsupport; ++i)
+    {
+        int varidx = model->objsupport[i];
+        SCIP_in_CSIP(SCIPchgVarObj(model->scip, model->vars[varidx], 0.0));
+        model->inobjsupport[varidx] = FALSE;
+    }
+    model->nobjsupport = 0;
+
+    CSIP_CALL(setObj(model, numindices, indices, coefs));
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetQuadObj(CSIP_MODEL *model, int numlinindices,
+                            int *linindices, double *lincoefs, int numquadterms,
+                            int *quadrowindices, int *quadcolindices,
+                            double *quadcoefs)
+{
+    int nprods;
+    int i;
+    int opidx;
+    int nops;
+    int nchildren;
+    CSIP_OP *ops;
+    int *children;
+    int *begin;
+    int *prodindices;
+    double *values;
+
+    // build the expression representation of a quadratic
+    // there are: numlinindices VARIDX, CONST and PROD for the linear part
+    // nquadterms VARIDX, VARIDX, CONST and PROD for the quadratic part
+    // So there are 3*numlindices + 4*nquadterms operators plus 1 (the sum)
+    // Number of children: each VARIDX and CONST contribute with one:
+    // nchildren >= 2*numlinindices + 3*nquadterms
+    // Then each PROD in numlinindices contribute with 2 and in nquadterms with 3
+    // nchildren >= 4*numlinindices + 6*nquadterms
+    // The final sum has as many children as products are there, nlinind + nquadterms
+    // nchildren = 5*numlinindices + 7*nquadterms
+    // NOTE: we will need to store the indices of the PROD operators
+    //       and all coefs in a single array `values`
+    nprods = numquadterms + numlinindices;
+    nchildren = 5 * numlinindices + 7 * numquadterms;
+    nops = 3 * numlinindices + 4 * numquadterms + 1;
+
+    ops = (int *) malloc(nops * sizeof(CSIP_OP));
+    children = (int *) malloc(nchildren * sizeof(int));
+    begin = (int *) malloc((nops + 1) * sizeof(int));
+    values = (double *) malloc(nprods * sizeof(double));
+    prodindices = (int *) malloc(nprods * sizeof(int));
+
+    begin[0] = 0;
+    opidx = -1;
+    // linear part
+    for (i = 0; i < numlinindices; ++i)
+    {
+        // variable
+        ++opidx;
+        ops[opidx] = VARIDX;
+        begin[opidx + 1] = begin[opidx] + 1; // where its children end
+        children[begin[opidx]] = linindices[i]; //children
+
+        // next operator: coef
+        ++opidx;
+        ops[opidx] = CONST;
+        begin[opidx + 1] = begin[opidx] + 1;
+        children[begin[opidx]] = i;
+        values[i] = lincoefs[i];
+
+        // next operator: PROD between coef and variable
+        ++opidx;
+        ops[opidx] = PROD;
+        begin[opidx + 1] = begin[opidx] + 2;
+        children[begin[opidx]] = opidx - 2;
+        children[begin[opidx] + 1] = opidx - 1;
+
+        prodindices[i] = opidx;
+    }
+    // quadratic part
+    for (i = 0; i < numquadterms; ++i)
+    {
+        // variable 1
+        ++opidx;
+        ops[opidx] = VARIDX;
+        begin[opidx + 1] = begin[opidx] + 1; // where its children end
+        children[begin[opidx]] = quadrowindices[i]; //children
+
+        // variable 2
+        ++opidx;
+        ops[opidx] = VARIDX;
+        begin[opidx + 1] = begin[opidx] + 1; // where its children end
+        children[begin[opidx]] = quadcolindices[i]; //children
+
+        // coef
+        ++opidx;
+        ops[opidx] = CONST;
+        begin[opidx + 1] = begin[opidx] + 1;
+        children[begin[opidx]] = i + numlinindices;
+        values[i + numlinindices] = quadcoefs[i];
+
+        // next operator: PROD between var1, var2 and coef
+        ++opidx;
+        ops[opidx] = PROD;
+        begin[opidx + 1] = begin[opidx] + 3;
+        children[begin[opidx]] = opidx - 3;
+        children[begin[opidx] + 1] = opidx - 2;
+        children[begin[opidx] + 2] = opidx - 1;
+
+        prodindices[i + numlinindices] = opidx;
+    }
+
+    // sum all PRODs
+    ++opidx;
+    ops[opidx] = SUM;
+    begin[opidx + 1] = begin[opidx] + nprods;
+    for (i = 0; i < nprods; ++i)
+    {
+        children[begin[opidx] + i] = prodindices[i];
+    }
+
+    CSIP_CALL(CSIPsetNonlinearObj(model, nops, ops, children, begin, values));
+
+    // free everything
+    free(ops);
+    free(children);
+    free(begin);
+    free(values);
+    free(prodindices);
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetNonlinearObj(
+    CSIP_MODEL *model, int nops, CSIP_OP *ops, int *children, int *begin,
+    double *values)
+{
+    SCIP *scip;
+    SCIP_EXPRTREE *tree;
+    SCIP_CONS *cons;
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETNONLINEAROBJ);
+        recordExpr(model, nops, ops, children, begin, values);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(createExprtree(model, nops, ops, children, begin,
+                             values, &tree));
+
+    scip = model->scip;
+    CSIP_CALL(freeTransform(model));
+    CSIP_CALL(freeGradEval(&model->objgradeval));
+
+    // create nonlinear objective constraint
+    SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(scip, &cons,
+                 "nonlin_obj", 0, NULL, NULL, 1, &tree, NULL,
+                 -SCIPinfinity(scip), 0.0));
+
+    // add objvar to nonlinear objective
+    if (model->objvar != NULL)
+    {
+        SCIP_in_CSIP(SCIPchgVarObj(scip, model->objvar, 0.0));
+        SCIP_in_CSIP(SCIPchgVarLb(scip, model->objvar, -SCIPinfinity(scip)));
+        SCIP_in_CSIP(SCIPchgVarUb(scip, model->objvar, SCIPinfinity(scip)));
+
+        // we do not need to remember this variable anymore nor objcons
+        SCIP_in_CSIP(SCIPreleaseVar(scip, &model->objvar));
+        SCIP_in_CSIP(SCIPreleaseCons(scip, &model->objcons));
+    }
+    assert(model->objvar == NULL);
+    assert(model->objcons == NULL);
+
+    SCIP_in_CSIP(SCIPcreateVarBasic(scip, &model->objvar, NULL,
+                                    -SCIPinfinity(scip), SCIPinfinity(scip), 1.0,
+                                    SCIP_VARTYPE_CONTINUOUS));
+    SCIP_in_CSIP(SCIPaddVar(scip, model->objvar));
+    SCIP_in_CSIP(SCIPaddLinearVarNonlinear(scip, cons, model->objvar, -1.0));
+
+    // add objective constraint and remember it
+    SCIP_in_CSIP(SCIPaddCons(scip, cons));
+    model->objcons = cons;
+    model->objtype = CSIP_OBJTYPE_NONLINEAR;
+    model->objcurvature = CSIP_CURVATURE_UNKNOWN;
+
+    // the created constraint is correct if sense is minimize, otherwise we
+    // have to correct it
+    if (SCIPgetObjsense(model->scip) == SCIP_OBJSENSE_MAXIMIZE)
+    {
+        CSIP_CALL(correctObjectiveFunction(model));
+    }
+
+    // free memory
+    SCIP_in_CSIP(SCIPexprtreeFree(&tree));
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetSenseMinimize(CSIP_MODEL *model)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETSENSEMIN);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    if (SCIPgetObjsense(model->scip) != SCIP_OBJSENSE_MINIMIZE)
+    {
+        SCIP_in_CSIP(SCIPsetObjsense(model->scip, SCIP_OBJSENSE_MINIMIZE));
+        CSIP_CALL(correctObjectiveFunction(model));
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetSenseMaximize(CSIP_MODEL *model)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETSENSEMAX);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    if (SCIPgetObjsense(model->scip) != SCIP_OBJSENSE_MAXIMIZE)
+    {
+        SCIP_in_CSIP(SCIPsetObjsense(model->scip, SCIP_OBJSENSE_MAXIMIZE));
+        CSIP_CALL(correctObjectiveFunction(model));
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+/* SCIP's nonlinear constraint handler can only be told that all of its
+ * constraints are convex. Thus, we set assumeconvex if every nonlinear
+ * constraint is declared convex where bounded from above and concave where
+ * bounded from below, and the objective agrees with the sense. Otherwise the
+ * user's value is kept, or restored if the hints set it on an earlier solve. */
+static
+CSIP_RETCODE applyCurvatureHints(CSIP_MODEL *model)
+{
+    SCIP *scip = model->scip;
+    SCIP_Bool hinted = (model->objtype == CSIP_OBJTYPE_NONLINEAR
+                        && model->objcurvature != CSIP_CURVATURE_UNKNOWN);
+    SCIP_Bool convex = TRUE;
+    int i;
+
+    for (i = 0; i < model->nconss; ++i)
+    {
+        SCIP_CONS *cons = model->conss[i];
+        CSIP_CURVATURE curv = model->conscurvature[i];
+
+        if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "nonlinear") != 0)
+        {
+            continue;
+        }
+        hinted = hinted || (curv != CSIP_CURVATURE_UNKNOWN);
+        if ((!SCIPisInfinity(scip, SCIPgetRhsNonlinear(scip, cons))
+                && curv != CSIP_CURVATURE_CONVEX)
+                || (!SCIPisInfinity(scip, -SCIPgetLhsNonlinear(scip, cons))
+                    && curv != CSIP_CURVATURE_CONCAVE))
+        {
+            convex = FALSE;
+        }
+    }
+
+    if (model->objtype == CSIP_OBJTYPE_NONLINEAR)
+    {
+        CSIP_CURVATURE goodcurv =
+            (SCIPgetObjsense(scip) == SCIP_OBJSENSE_MINIMIZE) ?
+            CSIP_CURVATURE_CONVEX : CSIP_CURVATURE_CONCAVE;
+        convex = convex && (model->objcurvature == goodcurv);
+    }
+
+    if (hinted && convex && !model->assumeconvexset)
+    {
+        SCIP_in_CSIP(SCIPgetBoolParam(scip, "constraints/nonlinear/assumeconvex",
+                                      &model->userassumeconvex));
+        SCIP_in_CSIP(SCIPsetBoolParam(scip, "constraints/nonlinear/assumeconvex",
+                                      TRUE));
+        model->assumeconvexset = TRUE;
+    }
+    else if (!(hinted && convex) && model->assumeconvexset)
+    {
+        SCIP_in_CSIP(SCIPsetBoolParam(scip, "constraints/nonlinear/assumeconvex",
+                                      model->userassumeconvex));
+        model->assumeconvexset = FALSE;
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+/* Repairs an infeasible solution by solving a copy of the problem for the
+ * solution closest to it, in two stages: the first minimizes the number of
+ * binary variables that flip, the second the distance of the other variables
+ * to their values in sol, keeping at most as many flips as the first found.
+ * Both share the time budget; if the second stage finds nothing, the solution
+ * of the first is used. The copy may lack constraints of callbacks, so a
+ * repaired solution is only added if it is feasible for the model. */
+static
+CSIP_RETCODE repairSolution(CSIP_MODEL *model, SCIP_SOL *sol,
+                            SCIP_Bool *repaired)
+{
+    SCIP *scip = model->scip;
+    SCIP *subscip;
+    SCIP_HASHMAP *varmap;
+    SCIP_VAR **vars;
+    SCIP_VAR **subvars;
+    SCIP_VAR **binvars;
+    SCIP_VAR **devvars;
+    SCIP_SOL *newsol = NULL;
+    double *bincoefs;
+    SCIP_Bool valid;
+    int nbinvars = 0;
+    int ndevvars = 0;
+    int nvars;
+    int i;
+
+    *repaired = FALSE;
+
+    SCIP_in_CSIP(SCIPcreate(&subscip));
+    SCIP_in_CSIP(SCIPhashmapCreate(&varmap, SCIPblkmem(subscip),
+                                   SCIPgetNOrigVars(scip) + 1));
+    SCIP_in_CSIP(SCIPcopyOrig(scip, subscip, varmap, NULL, "", FALSE, FALSE,
+                              &valid));
+    SCIP_in_CSIP(SCIPsetIntParam(subscip, "display/verblevel", 0));
+    SCIP_in_CSIP(SCIPsetRealParam(subscip, "limits/time", model->repairbudget));
+    SCIP_in_CSIP(SCIPsetObjsense(subscip, SCIP_OBJSENSE_MINIMIZE));
+
+    subvars = SCIPgetOrigVars(subscip);
+    for (i = 0; i < SCIPgetNOrigVars(subscip); ++i)
+    {
+        SCIP_in_CSIP(SCIPchgVarObj(subscip, subvars[i], 0.0));
+    }
+
+    binvars = (SCIP_VAR **) malloc(MAX(1, model->nvars) * sizeof(SCIP_VAR *));
+    bincoefs = (double *) malloc(MAX(1, model->nvars) * sizeof(double));
+    devvars = (SCIP_VAR **) malloc(MAX(1, 2 * model->nvars) * sizeof(
+                                       SCIP_VAR *));
+    if (binvars == NULL || bincoefs == NULL || devvars == NULL)
+    {
+        free(devvars);
+        free(bincoefs);
+        free(binvars);
+        SCIPhashmapFree(&varmap);
+        SCIP_in_CSIP(SCIPfree(&subscip));
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    // first stage: flips in the objective
+    for (i = 0; i < model->nvars; ++i)
+    {
+        SCIP_VAR *subvar = (SCIP_VAR *) SCIPhashmapGetImage(varmap,
+                           model->vars[i]);
+        double val = SCIPgetSolVal(scip, sol, model->vars[i]);
+
+        if (val != val || SCIPisInfinity(scip, REALABS(val)))
+        {
+            continue;
+        }
+        if (SCIPvarIsBinary(subvar))
+        {
+            binvars[nbinvars] = subvar;
+            bincoefs[nbinvars] = val > 0.5 ? -1.0 : 1.0;
+            SCIP_in_CSIP(SCIPchgVarObj(subscip, subvar, bincoefs[nbinvars]));
+            ++nbinvars;
+        }
+        else
+        {
+            // subvar - up + down == val, with up and down in the objective of
+            // the second stage
+            SCIP_VAR *consvars[3];
+            double devcoefs[3] = {1.0, -1.0, 1.0};
+            SCIP_CONS *devcons;
+
+            consvars[0] = subvar;
+            SCIP_in_CSIP(SCIPcreateVarBasic(subscip, &consvars[1], NULL, 0.0,
+                                            SCIPinfinity(subscip), 0.0,
+                                            SCIP_VARTYPE_CONTINUOUS));
+            SCIP_in_CSIP(SCIPcreateVarBasic(subscip, &consvars[2], NULL, 0.0,
+                                            SCIPinfinity(subscip), 0.0,
+                                            SCIP_VARTYPE_CONTINUOUS));
+            SCIP_in_CSIP(SCIPaddVar(subscip, consvars[1]));
+            SCIP_in_CSIP(SCIPaddVar(subscip, consvars[2]));
+            SCIP_in_CSIP(SCIPcreateConsBasicLinear(subscip, &devcons, "repair",
+                                                   3, consvars, devcoefs, val, val));
+            SCIP_in_CSIP(SCIPaddCons(subscip, devcons));
+            SCIP_in_CSIP(SCIPreleaseCons(subscip, &devcons));
+            // still captured by subscip
+            devvars[ndevvars++] = consvars[1];
+            devvars[ndevvars++] = consvars[2];
+            SCIP_in_CSIP(SCIPreleaseVar(subscip, &consvars[1]));
+            SCIP_in_CSIP(SCIPreleaseVar(subscip, &consvars[2]));
+        }
+    }
+
+    // all variables of the model, including auxiliary ones
+    vars = SCIPgetOrigVars(scip);
+    nvars = SCIPgetNOrigVars(scip);
+
+    // with nothing to weigh against each other, one stage suffices
+    if (nbinvars == 0)
+    {
+        for (i = 0; i < ndevvars; ++i)
+        {
+            SCIP_in_CSIP(SCIPchgVarObj(subscip, devvars[i], 1.0));
+        }
+    }
+
+    SCIP_in_CSIP(SCIPsolve(subscip));
+
+    if (SCIPgetBestSol(subscip) != NULL)
+    {
+        SCIP_SOL *subsol = SCIPgetBestSol(subscip);
+        double flipsum = 0.0;
+        double remaining = model->repairbudget - SCIPgetSolvingTime(subscip);
+
+        SCIP_in_CSIP(SCIPcreateSol(scip, &newsol, NULL));
+        for (i = 0; i < nvars; ++i)
+        {
+            SCIP_VAR *subvar = (SCIP_VAR *) SCIPhashmapGetImage(varmap, vars[i]);
+
+            SCIP_in_CSIP(SCIPsetSolVal(scip, newsol, vars[i],
+                                       SCIPgetSolVal(subscip, subsol, subvar)));
+        }
+
+        // second stage: distance in the objective, flips bounded
+        if (nbinvars > 0 && ndevvars > 0 && remaining > 0.0)
+        {
+            SCIP_CONS *flipcons;
+
+            for (i = 0; i < nbinvars; ++i)
+            {
+                flipsum += bincoefs[i] * SCIPgetSolVal(subscip, subsol,
+                                                     binvars[i]);
+            }
+
+            SCIP_in_CSIP(SCIPfreeTransform(subscip));
+            SCIP_in_CSIP(SCIPsetRealParam(subscip, "limits/time", remaining));
+            for (i = 0; i < nbinvars; ++i)
+            {
+                SCIP_in_CSIP(SCIPchgVarObj(subscip, binvars[i], 0.0));
+            }
+            for (i = 0; i < ndevvars; ++i)
+            {
+                SCIP_in_CSIP(SCIPchgVarObj(subscip, devvars[i], 1.0));
+            }
+            SCIP_in_CSIP(SCIPcreateConsBasicLinear(subscip, &flipcons,
+                                                   "repair_flips", nbinvars,
+                                                   binvars, bincoefs,
+                                                   -SCIPinfinity(subscip),
+                                                   flipsum + 0.5));
+            SCIP_in_CSIP(SCIPaddCons(subscip, flipcons));
+            SCIP_in_CSIP(SCIPreleaseCons(subscip, &flipcons));
+
+            SCIP_in_CSIP(SCIPsolve(subscip));
+
+            subsol = SCIPgetBestSol(subscip);
+            for (i = 0; i < nvars && subsol != NULL; ++i)
+            {
+                SCIP_VAR *subvar = (SCIP_VAR *) SCIPhashmapGetImage(varmap,
+                                   vars[i]);
+
+                SCIP_in_CSIP(SCIPsetSolVal(scip, newsol, vars[i],
+                                           SCIPgetSolVal(subscip, subsol,
+                                                         subvar)));
+            }
+        }
+    }
+
+    // the copy may be incomplete and the second stage cut short, so the
+    // repaired solution is checked against the model itself
+    if (newsol != NULL)
+    {
+        SCIP_Bool feasible;
+
+        SCIP_in_CSIP(SCIPcheckSolOrig(scip, newsol, &feasible, FALSE, FALSE));
+        if (feasible)
+        {
+            unsigned int stored;
+
+            SCIP_in_CSIP(SCIPaddSolFree(scip, &newsol, &stored));
+            *repaired = stored;
+        }
+        else
+        {
+            SCIP_in_CSIP(SCIPfreeSol(scip, &newsol));
+        }
+    }
+
+    free(devvars);
+    free(bincoefs);
+    free(binvars);
+    SCIPhashmapFree(&varmap);
+    SCIP_in_CSIP(SCIPfree(&subscip));
+
+    return CSIP_RETCODE_OK;
+}
+
+// result of a solve, to compare with on replay
+static
+void recordSolved(CSIP_MODEL *model)
+{
+    SCIP_SOL *sol;
+    long long nnodes;
+
+    if (model->recording == NULL)
+    {
+        return;
+    }
+
+    sol = SCIPgetBestSol(model->scip);
+    nnodes = SCIPgetNNodes(model->scip);
+    recordOp(model, RECORD_SOLVED);
+    recordInt(model, CSIPgetStatus(model));
+    recordArray(model, RECORD_LONGS, 1, &nnodes, sizeof(long long));
+    recordDouble(model, SCIPgetSolvingTime(model->scip));
+    recordDouble(model, sol != NULL ? SCIPgetSolOrigObj(model->scip, sol) :
+                 NAN);
+    recordEnd(model);
+    fflush(model->recording);
+}
+
+CSIP_RETCODE CSIPsolve(CSIP_MODEL *model)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SOLVE);
+        recordEnd(model);
+    }
+
+    // add initial solution
+    model->initialsolstatus = CSIP_INITSOL_NONE;
+    if (model->initialsol != NULL)
+    {
+        unsigned int stored;
+        SCIP_Bool initialsolpartial =
+            (SCIPsolGetOrigin(model->initialsol) == SCIP_SOLORIGIN_PARTIAL);
+
+        /* if objective is nonlinear, we need to extend the initial sol with
+         * the value of objvar. For this we need to change the objective
+         * constraint temporarily to an equality constraint. However the
+         * nonlinear contraint handler doesn't allow to change sides, so
+         * we have to create a brand new constraint to compute the violation
+         *
+         * This is not true if the user has given a partial sol, because then
+         * we can safely leave the value for the objval unspecified. In fact,
+         * that's preferred, because computing the violation might fail.
+         */
+        if (model->objcons != NULL && !initialsolpartial)
+        {
+            SCIP_CONS* tempcons;
+            SCIP_Real objvarval;
+            SCIP_EXPRTREE *tree;
+
+            /* we do not care about the sign of the expression tree, since
+             * tempcons is equality and this already gives the correct sign for
+             * objvarval */
+            tree = SCIPgetExprtreesNonlinear(model->scip, model->objcons)[0];
+            SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(model->scip, &tempcons,
+                     "temp_nonlin_obj", 0, NULL, NULL, 1, &tree, NULL,
+                     0.0, 0.0));
+            SCIP_in_CSIP(SCIPgetViolationNonlinear(model->scip, tempcons,
+                     model->initialsol, &objvarval) );
+
+            SCIP_in_CSIP(SCIPreleaseCons(model->scip, &tempcons));
+
+            SCIP_in_CSIP(SCIPsetSolVals(model->scip, model->initialsol, 1,
+                     &model->objvar, &objvarval));
+        }
+
+
+        if (initialsolpartial)
+        {
+            model->initialsolstatus = CSIP_INITSOL_PARTIAL;
+            SCIP_in_CSIP(SCIPaddSolFree(model->scip, &model->initialsol, &stored));
+        }
+        else
+        {
+            SCIP_Bool feasible;
+
+            SCIP_in_CSIP(SCIPcheckSolOrig(model->scip, model->initialsol,
+                                          &feasible, FALSE, FALSE));
+            if (feasible)
+            {
+                model->initialsolstatus = CSIP_INITSOL_FEASIBLE;
+                SCIP_in_CSIP(SCIPaddSolFree(model->scip, &model->initialsol,
+                                            &stored));
+            }
+            else
+            {
+                SCIP_Bool repaired = FALSE;
+
+                if (model->repairbudget > 0.0)
+                {
+                    CSIP_RETCODE retcode = repairSolution(model,
+                                                          model->initialsol,
+                                                          &repaired);
+
+                    if (retcode != CSIP_RETCODE_OK)
+                    {
+                        return retcode;
+                    }
+                }
+                model->initialsolstatus = repaired ? CSIP_INITSOL_REPAIRED :
+                                          CSIP_INITSOL_INFEASIBLE;
+                SCIPwarningMessage(model->scip, "initial solution is "
+                                   "infeasible, %s\n", repaired ?
+                                   "added a repaired solution" : "discarded");
+                SCIP_in_CSIP(SCIPfreeSol(model->scip, &model->initialsol));
+            }
+        }
+    }
+
+    CSIP_CALL(applyCurvatureHints(model));
+
+    resetProgress(model);
+    metricsSolveStarted();
+
+    CSIP_PROBE2(solve__start, model, model->nvars);
+    SCIP_in_CSIP(SCIPsolve(model->scip));
+
+    // a finished search has explored the whole tree
+    updateProgress(model, 0.0);
+    if (SCIPgetStage(model->scip) == SCIP_STAGE_SOLVED)
+    {
+        CSIP_PROGRESS progress = model->progress;
+
+        progress.treeweight = 1.0;
+        progress.gapclosed = 1.0;
+        progress.treesize = progress.nnodes;
+        progress.remainingtime = 0.0;
+        setProgress(model, &progress);
+    }
+    flushMetrics(model);
+    recordSolved(model);
+    CSIP_PROBE3(solve__done, model, (int) SCIPgetStatus(model->scip),
+                (long long) SCIPgetNNodes(model->scip));
+
+    return CSIP_RETCODE_OK;
+}
+
+/* Polishing resumes the interrupted search for a bounded number of nodes,
+ * with the improvement heuristics around the incumbent run at every node and
+ * without further cutting, so that the LP relaxation stays as it is. The
+ * incumbent is the cutoff bound of the resumed tree, so only nodes that may
+ * improve on it are explored. The search stops after POLISHNODES nodes or
+ * when the time budget is spent; the limits that may have stopped it before
+ * (gap, stall nodes, solutions) are lifted. The time and node limits are
+ * relative to the interrupted search and set in CSIPpolish. */
+struct polish_param
+{
+    const char *name;
+    CSIP_PARAMTYPE type;
+    double value;
+};
+
+#define POLISHPARAM_TIME 0
+#define POLISHPARAM_NODES 1
+
+static const struct polish_param polishparams[] =
+{
+    {"limits/time", CSIP_PARAMTYPE_REAL, 0.0},
+    {"limits/nodes", CSIP_PARAMTYPE_LONGINT, 0.0},
+    {"limits/stallnodes", CSIP_PARAMTYPE_LONGINT, -1.0},
+    {"limits/gap", CSIP_PARAMTYPE_REAL, 0.0},
+    {"limits/absgap", CSIP_PARAMTYPE_REAL, 0.0},
+    {"limits/solutions", CSIP_PARAMTYPE_INT, -1.0},
+    {"limits/bestsol", CSIP_PARAMTYPE_INT, -1.0},
+    {"separating/maxrounds", CSIP_PARAMTYPE_INT, 0.0},
+    {"heuristics/rins/freq", CSIP_PARAMTYPE_INT, 1.0},
+    {"heuristics/rins/nodesquot", CSIP_PARAMTYPE_REAL, 0.5},
+    {"heuristics/localbranching/freq", CSIP_PARAMTYPE_INT, 1.0},
+    {"heuristics/localbranching/nodesquot", CSIP_PARAMTYPE_REAL, 0.5},
+    {"heuristics/crossover/freq", CSIP_PARAMTYPE_INT, 1.0},
+    {"heuristics/mutation/freq", CSIP_PARAMTYPE_INT, 1.0},
+    {"heuristics/mutation/freqofs", CSIP_PARAMTYPE_INT, 0.0},
+};
+
+#define NPOLISHPARAMS (int) (sizeof(polishparams) / sizeof(polishparams[0]))
+#define POLISHNODES 1000
+
+// errors are returned, so that the caller can restore what it changed
+static
+CSIP_RETCODE getNumParam(SCIP *scip, const char *name, CSIP_PARAMTYPE type,
+                         double *value)
+{
+    SCIP_RETCODE retcode;
+    int intval;
+    SCIP_Longint longval;
+
+    switch (type)
+    {
+    case CSIP_PARAMTYPE_INT:
+        retcode = SCIPgetIntParam(scip, name, &intval);
+        *value = intval;
+        break;
+    case CSIP_PARAMTYPE_LONGINT:
+        retcode = SCIPgetLongintParam(scip, name, &longval);
+        *value = (double) longval;
+        break;
+    default:
+        retcode = SCIPgetRealParam(scip, name, value);
+        break;
+    }
+
+    return retCodeSCIPtoCSIP(retcode);
+}
+
+static
+CSIP_RETCODE setNumParam(SCIP *scip, const char *name, CSIP_PARAMTYPE type,
+                         double value)
+{
+    switch (type)
+    {
+    case CSIP_PARAMTYPE_INT:
+        return retCodeSCIPtoCSIP(SCIPsetIntParam(scip, name, (int) value));
+    case CSIP_PARAMTYPE_LONGINT:
+        return retCodeSCIPtoCSIP(SCIPsetLongintParam(scip, name,
+                                 (SCIP_Longint) value));
+    default:
+        return retCodeSCIPtoCSIP(SCIPsetRealParam(scip, name, value));
+    }
+}
+
+CSIP_RETCODE CSIPpolish(CSIP_MODEL *model, double timebudget)
+{
+    SCIP *scip = model->scip;
+    double values[NPOLISHPARAMS];
+    double saved[NPOLISHPARAMS];
+    SCIP_Bool restore[NPOLISHPARAMS];
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
+    int i;
+
+    if (timebudget < 0.0 || SCIPgetBestSol(scip) == NULL)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_POLISH);
+        recordDouble(model, timebudget);
+        recordEnd(model);
+    }
+
+    // nothing to improve after a finished search
+    if (SCIPgetStage(scip) == SCIP_STAGE_SOLVED)
+    {
+        return CSIP_RETCODE_OK;
+    }
+
+    for (i = 0; i < NPOLISHPARAMS; ++i)
+    {
+        values[i] = polishparams[i].value;
+        restore[i] = FALSE;
+    }
+    values[POLISHPARAM_TIME] = SCIPgetSolvingTime(scip) + timebudget;
+    values[POLISHPARAM_NODES] = (double) (SCIPgetNNodes(scip) + POLISHNODES);
+
+    for (i = 0; i < NPOLISHPARAMS && retcode == CSIP_RETCODE_OK; ++i)
+    {
+        const struct polish_param *param = &polishparams[i];
+
+        // heuristics may be excluded from the build
+        if (SCIPgetParam(scip, param->name) == NULL)
+        {
+            continue;
+        }
+        retcode = getNumParam(scip, param->name, param->type, &saved[i]);
+        if (retcode == CSIP_RETCODE_OK)
+        {
+            restore[i] = TRUE;
+            retcode = setNumParam(scip, param->name, param->type, values[i]);
+        }
+    }
+
+    if (retcode == CSIP_RETCODE_OK)
+    {
+        metricsSolveStarted();
+        CSIP_PROBE2(solve__start, model, model->nvars);
+        retcode = retCodeSCIPtoCSIP(SCIPsolve(scip));
+        updateProgress(model, 0.0);
+        flushMetrics(model);
+        recordSolved(model);
+        CSIP_PROBE3(solve__done, model, (int) SCIPgetStatus(scip),
+                    (long long) SCIPgetNNodes(scip));
+    }
+
+    // restore everything that was changed, keeping the first error
+    for (i = 0; i < NPOLISHPARAMS; ++i)
+    {
+        const struct polish_param *param = &polishparams[i];
+        CSIP_RETCODE restored;
+
+        if (!restore[i])
+        {
+            continue;
+        }
+        restored = setNumParam(scip, param->name, param->type, saved[i]);
+        if (retcode == CSIP_RETCODE_OK)
+        {
+            retcode = restored;
+        }
+    }
+
+    return retcode;
+}
+
+CSIP_RETCODE CSIPsetNonLinConsCurvature(
+    CSIP_MODEL *model, int considx, CSIP_CURVATURE curvature)
+{
+    SCIP_CONS *cons;
+
+    if (considx < 0 || considx >= model->nconss)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    cons = model->conss[considx];
+    if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "nonlinear") != 0)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETNONLINCONSCURVATURE);
+        recordInt(model, considx);
+        recordInt(model, curvature);
+        recordEnd(model);
+    }
+
+    model->conscurvature[considx] = curvature;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetNonlinearObjCurvature(
+    CSIP_MODEL *model, CSIP_CURVATURE curvature)
+{
+    if (model->objtype != CSIP_OBJTYPE_NONLINEAR)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETNONLINEAROBJCURVATURE);
+        recordInt(model, curvature);
+        recordEnd(model);
+    }
+
+    model->objcurvature = curvature;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPinterrupt(CSIP_MODEL *model)
+{
+    SCIP_in_CSIP(SCIPinterruptSolve(model->scip));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_STATUS CSIPgetStatus(CSIP_MODEL *model)
+{
+    switch (SCIPgetStatus(model->scip))
+    {
+    case SCIP_STATUS_UNKNOWN:
+        return CSIP_STATUS_UNKNOWN;
+    case SCIP_STATUS_USERINTERRUPT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_NODELIMIT:
+        return CSIP_STATUS_NODELIMIT;
+    case SCIP_STATUS_TOTALNODELIMIT:
+        return CSIP_STATUS_NODELIMIT;
+    case SCIP_STATUS_STALLNODELIMIT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_TIMELIMIT:
+        return CSIP_STATUS_TIMELIMIT;
+    case SCIP_STATUS_MEMLIMIT:
+        return CSIP_STATUS_MEMLIMIT;
+    case SCIP_STATUS_GAPLIMIT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_SOLLIMIT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_BESTSOLLIMIT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_RESTARTLIMIT:
+        return CSIP_STATUS_USERLIMIT;
+    case SCIP_STATUS_OPTIMAL:
+        return CSIP_STATUS_OPTIMAL;
+    case SCIP_STATUS_INFEASIBLE:
+        return CSIP_STATUS_INFEASIBLE;
+    case SCIP_STATUS_UNBOUNDED:
+        return CSIP_STATUS_UNBOUNDED;
+    case SCIP_STATUS_INFORUNBD:
+        return CSIP_STATUS_INFORUNBD;
+    default:
+        return CSIP_STATUS_UNKNOWN;
+    }
+}
+
+double CSIPgetObjValue(CSIP_MODEL *model)
+{
+    SCIP_SOL *sol = SCIPgetBestSol(model->scip);
+    if (sol == NULL)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    return SCIPgetSolOrigObj(model->scip, sol);
+}
+
+double CSIPgetObjBound(CSIP_MODEL *model)
+{
+    return SCIPgetDualbound(model->scip);
+}
+
+
+CSIP_RETCODE CSIPgetVarValues(CSIP_MODEL *model, double *output)
+{
+    int i;
+    SCIP *scip;
+    SCIP_VAR *var;
+
+    scip = model->scip;
+
+    if (SCIPgetBestSol(scip) == NULL)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    for (i = 0; i < model->nvars; ++i)
+    {
+        var = model->vars[i];
+        output[i] = SCIPgetSolVal(scip, SCIPgetBestSol(scip), var);
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+// makes room for base values of all variables
+static
+CSIP_RETCODE reserveBaseValues(CSIP_MODEL *model)
+{
+    double *basevalues;
+
+    if (model->nbasevalues >= model->nvars)
+    {
+        return CSIP_RETCODE_OK;
+    }
+
+    basevalues = (double *) realloc(model->basevalues,
+                                    model->nvars * sizeof(double));
+    if (basevalues == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    model->basevalues = basevalues;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPgetVarValueChanges(CSIP_MODEL *model, int *nchanged,
+                                    int *indices, double *newvalues)
+{
+    SCIP *scip = model->scip;
+    SCIP_SOL *sol = SCIPgetBestSol(scip);
+    int i;
+
+    if (sol == NULL)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    CSIP_CALL(reserveBaseValues(model));
+
+    // variables without a base value count as changed
+    *nchanged = 0;
+    for (i = 0; i < model->nvars; ++i)
+    {
+        double value = SCIPgetSolVal(scip, sol, model->vars[i]);
+        double basevalue = model->basevalues[i];
+
+        if (i >= model->nbasevalues || basevalue != basevalue
+                || (model->basetolerance < 0.0 ?
+                    !SCIPisFeasEQ(scip, value, basevalue) :
+                    REALABS(value - basevalue) > model->basetolerance))
+        {
+            indices[*nchanged] = i;
+            newvalues[*nchanged] = value;
+            ++(*nchanged);
+            model->basevalues[i] = value;
+        }
+    }
+    model->nbasevalues = model->nvars;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetVarValueBaseline(CSIP_MODEL *model, double *values)
+{
+    if (values == NULL)
+    {
+        model->nbasevalues = 0;
+        return CSIP_RETCODE_OK;
+    }
+
+    CSIP_CALL(reserveBaseValues(model));
+    memcpy(model->basevalues, values, model->nvars * sizeof(double));
+    model->nbasevalues = model->nvars;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetVarValueTolerance(CSIP_MODEL *model, double tolerance)
+{
+    if (tolerance != tolerance)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    model->basetolerance = tolerance;
+
+    return CSIP_RETCODE_OK;
+}
+
+// Get the type of a parameter
+CSIP_PARAMTYPE CSIPgetParamType(CSIP_MODEL *model, const char *name)
+{
+    SCIP_PARAM *param;
+
+    param = SCIPgetParam(model->scip, name);
+    if (param == NULL)
+    {
+        return CSIP_PARAMTYPE_NOTAPARAM;
+    }
+    else
+    {
+        return SCIPparamGetType(param);
+    }
+}
+
+CSIP_RETCODE CSIPsetBoolParam(
+    CSIP_MODEL *model, const char *name, int value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETBOOLPARAM);
+        recordString(model, name);
+        recordInt(model, value);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetBoolParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPgetBoolParam(
+    CSIP_MODEL *model, const char *name, int *value)
+{
+    SCIP_Bool scipvalue;
+
+    SCIP_in_CSIP(SCIPgetBoolParam(model->scip, name, &scipvalue));
+    *value = scipvalue;
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetIntParam(
+    CSIP_MODEL *model, const char *name, int value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETINTPARAM);
+        recordString(model, name);
+        recordInt(model, value);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetIntParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetLongintParam(
+    CSIP_MODEL *model, const char *name, long long value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETLONGINTPARAM);
+        recordString(model, name);
+        recordArray(model, RECORD_LONGS, 1, &value, sizeof(long long));
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetLongintParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetRealParam(
+    CSIP_MODEL *model, const char *name, double value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETREALPARAM);
+        recordString(model, name);
+        recordDouble(model, value);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetRealParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetCharParam(
+    CSIP_MODEL *model, const char *name, char value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETCHARPARAM);
+        recordString(model, name);
+        recordInt(model, value);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetCharParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetStringParam(
+    CSIP_MODEL *model, const char *name, const char *value)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETSTRINGPARAM);
+        recordString(model, name);
+        recordString(model, value);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPsetStringParam(model->scip, name, value));
+    return CSIP_RETCODE_OK;
+}
+
+int CSIPgetNumVars(CSIP_MODEL *model)
+{
+    return model->nvars;
+}
+
+int CSIPgetNumConss(CSIP_MODEL *model)
+{
+    return model->nconss;
+}
+
+CSIP_RETCODE CSIPsetInitialSolution(CSIP_MODEL *model, double *values)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETINITIALSOL);
+        recordDoubles(model, model->nvars, values);
+        recordEnd(model);
+    }
+
+    // are there missing values?
+    SCIP_Bool initialsolpartial = FALSE;
+    for(int i = 0; i < model->nvars; ++i)
+    {
+        SCIP_Real val = values[i];
+        if(val != val) // check for NaN
+        {
+            initialsolpartial = TRUE;
+            break;
+        }
+    }
+
+    // was solution already given?
+    if (model->initialsol != NULL)
+    {
+        SCIP_in_CSIP(SCIPfreeSol(model->scip, &model->initialsol));
+    }
+    assert(model->initialsol == NULL);
+
+    // create new solution object
+    if(initialsolpartial)
+    {
+        SCIP_in_CSIP(SCIPcreatePartialSol(model->scip, &model->initialsol, NULL));
+
+        // give only the proper values, skip NaN
+        for(int i = 0; i < model->nvars; ++i)
+        {
+            SCIP_Real val = values[i];
+            if(val == val) // check for NaN
+            {
+                SCIP_in_CSIP(SCIPsetSolVal(model->scip, model->initialsol,
+                                           model->vars[i], val));
+            }
+        }
+    }
+    else
+    {
+        SCIP_in_CSIP(SCIPcreateSol(model->scip, &model->initialsol, NULL));
+
+        // copy the given values
+        SCIP_in_CSIP(SCIPsetSolVals(model->scip, model->initialsol, model->nvars,
+                                    model->vars, values));
+    }
+
+    // it will be given to SCIP in the CSIPsolve call
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetInitialSolutionRepair(CSIP_MODEL *model, double timebudget)
+{
+    if (timebudget < 0.0)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETINITIALSOLREPAIR);
+        recordDouble(model, timebudget);
+        recordEnd(model);
+    }
+    model->repairbudget = timebudget;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_INITSOLSTATUS CSIPgetInitialSolutionStatus(CSIP_MODEL *model)
+{
+    return model->initialsolstatus;
+}
+
+CSIP_RETCODE CSIPsetWorkerCPUs(CSIP_MODEL *model, int nsets, int *beg,
+                               int *cpus)
+{
+    struct cpu_sets *workercpus = &model->workercpus;
+
+    free(workercpus->beg);
+    free(workercpus->cpus);
+    workercpus->nsets = 0;
+    workercpus->beg = NULL;
+    workercpus->cpus = NULL;
+    if (nsets == 0)
+    {
+        return CSIP_RETCODE_OK;
+    }
+
+    for (int i = 0; i < beg[nsets]; ++i)
+    {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    workercpus->beg = (int *) malloc((nsets + 1) * sizeof(int));
+    workercpus->cpus = (int *) malloc(MAX(1, beg[nsets]) * sizeof(int));
+    if (workercpus->beg == NULL || workercpus->cpus == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    memcpy(workercpus->beg, beg, (nsets + 1) * sizeof(int));
+    memcpy(workercpus->cpus, cpus, beg[nsets] * sizeof(int));
+    workercpus->nsets = nsets;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsetDeterministic(CSIP_MODEL *model, int deterministic)
+{
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETDETERMINISTIC);
+        recordInt(model, deterministic);
+        recordEnd(model);
+    }
+
+    model->deterministic = (deterministic != 0);
+
+    // SCIP's own concurrent solver, if it was built with one; turning
+    // determinism off leaves the user's setting alone
+    if (model->deterministic && SCIPgetParam(model->scip, "parallel/mode") != NULL)
+    {
+        SCIP_in_CSIP(SCIPsetIntParam(model->scip, "parallel/mode", 1));
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPgetProgressEstimate(CSIP_MODEL *model, CSIP_PROGRESS *est)
+{
+    pthread_mutex_lock(&model->progresslock);
+    *est = model->progress;
+    pthread_mutex_unlock(&model->progresslock);
+
+    return CSIP_RETCODE_OK;
+}
+
+void *CSIPgetInternalSCIP(CSIP_MODEL *model)
+{
+    return model->scip;
+}
+
+
+/*
+ * Gradient evaluation
+ */
+
+/* Expressions are copied and compiled by SCIP's expression interpreter on
+ * first use, which computes gradients in reverse mode. */
+
+static
+CSIP_RETCODE freeGradEval(struct grad_eval *gradeval)
+{
+    if (gradeval->tree == NULL)
+    {
+        return CSIP_RETCODE_OK;
+    }
+
+    SCIP_in_CSIP(SCIPexprtreeFree(&gradeval->tree));
+    free(gradeval->treevaridx);
+    free(gradeval->varidx);
+    free(gradeval->slot);
+
+    return CSIP_RETCODE_OK;
+}
+
+static
+int compareInts(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+// index of a variable of the model, the map is extended by new variables
+static
+CSIP_RETCODE getVarIndex(CSIP_MODEL *model, SCIP_VAR *var, int *idx)
+{
+    if (model->varindex == NULL)
+    {
+        SCIP_in_CSIP(SCIPhashmapCreate(&model->varindex,
+                                       SCIPblkmem(model->scip), model->nvars + 1));
+    }
+    for (; model->nvarindex < model->nvars; ++(model->nvarindex))
+    {
+        SCIP_in_CSIP(SCIPhashmapInsert(model->varindex,
+                                       model->vars[model->nvarindex],
+                                       (void *)(size_t)(model->nvarindex + 1)));
+    }
+
+    *idx = (int)(size_t) SCIPhashmapGetImage(model->varindex, var) - 1;
+
+    return CSIP_RETCODE_OK;
+}
+
+static
+CSIP_RETCODE compileGradEval(CSIP_MODEL *model, SCIP_EXPRTREE *tree,
+                             struct grad_eval *gradeval)
+{
+    SCIP_VAR **treevars = SCIPexprtreeGetVars(tree);
+    int ntreevars = SCIPexprtreeGetNVars(tree);
+    int i;
+
+    gradeval->treevaridx = (int *) malloc(MAX(1, ntreevars) * sizeof(int));
+    gradeval->varidx = (int *) malloc(MAX(1, ntreevars) * sizeof(int));
+    gradeval->slot = (int *) malloc(MAX(1, ntreevars) * sizeof(int));
+    if (gradeval->treevaridx == NULL || gradeval->varidx == NULL
+            || gradeval->slot == NULL)
+    {
+        free(gradeval->slot);
+        free(gradeval->varidx);
+        free(gradeval->treevaridx);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    // a variable appears in the tree once per occurrence in the expression
+    for (i = 0; i < ntreevars; ++i)
+    {
+        CSIP_CALL(getVarIndex(model, treevars[i], &gradeval->treevaridx[i]));
+        gradeval->varidx[i] = gradeval->treevaridx[i];
+    }
+    qsort(gradeval->varidx, ntreevars, sizeof(int), compareInts);
+    gradeval->nvars = 0;
+    for (i = 0; i < ntreevars; ++i)
+    {
+        if (i == 0 || gradeval->varidx[i] != gradeval->varidx[i - 1])
+        {
+            gradeval->varidx[gradeval->nvars++] = gradeval->varidx[i];
+        }
+    }
+    for (i = 0; i < ntreevars; ++i)
+    {
+        int *pos = (int *) bsearch(&gradeval->treevaridx[i], gradeval->varidx,
+                                   gradeval->nvars, sizeof(int), compareInts);
+        gradeval->slot[i] = (int)(pos - gradeval->varidx);
+    }
+
+    if (model->exprint == NULL)
+    {
+        SCIP_in_CSIP(SCIPexprintCreate(SCIPblkmem(model->scip),
+                                       &model->exprint));
+    }
+    SCIP_in_CSIP(SCIPexprtreeCopy(SCIPblkmem(model->scip), &gradeval->tree,
+                                  tree));
+    SCIP_in_CSIP(SCIPexprintCompile(model->exprint, gradeval->tree));
+
+    return CSIP_RETCODE_OK;
+}
+
+// compiled expression of constraint considx, or of the objective for -1
+static
+CSIP_RETCODE getGradEval(CSIP_MODEL *model, int considx,
+                         struct grad_eval **gradeval)
+{
+    SCIP_CONS *cons;
+
+    if (!(SCIPexprintGetCapability() & SCIP_EXPRINTCAPABILITY_GRADIENT))
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (considx == -1)
+    {
+        if (model->objtype != CSIP_OBJTYPE_NONLINEAR)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        cons = model->objcons;
+        *gradeval = &model->objgradeval;
+    }
+    else
+    {
+        if (considx < 0 || considx >= model->nconss)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        cons = model->conss[considx];
+        if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "nonlinear") != 0)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+
+        if (considx >= model->ngradevals)
+        {
+            int i;
+
+            model->gradevals = (struct grad_eval *) realloc(model->gradevals,
+                               model->nconss * sizeof(struct grad_eval));
+            if (model->gradevals == NULL)
+            {
+                return CSIP_RETCODE_NOMEMORY;
+            }
+            for (i = model->ngradevals; i < model->nconss; ++i)
+            {
+                model->gradevals[i].tree = NULL;
+            }
+            model->ngradevals = model->nconss;
+        }
+        *gradeval = &model->gradevals[considx];
+    }
+
+    if ((*gradeval)->tree == NULL)
+    {
+        return compileGradEval(model,
+                               SCIPgetExprtreesNonlinear(model->scip, cons)[0], *gradeval);
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPgetNonLinVars(CSIP_MODEL *model, int considx, int *nvars,
+                               int *indices)
+{
+    struct grad_eval *gradeval;
+    CSIP_RETCODE retcode = getGradEval(model, considx, &gradeval);
+
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        return retcode;
+    }
+
+    *nvars = gradeval->nvars;
+    if (indices != NULL)
+    {
+        memcpy(indices, gradeval->varidx, gradeval->nvars * sizeof(int));
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPevalGradBatch(CSIP_MODEL *model, int considx, int npoints,
+                               double *points, double *vals, double *grads)
+{
+    struct grad_eval *gradeval;
+    SCIP_Real *varvals;
+    SCIP_Real *treegrad;
+    CSIP_RETCODE retcode;
+    int ntreevars;
+    int p;
+    int i;
+
+    retcode = getGradEval(model, considx, &gradeval);
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        return retcode;
+    }
+    ntreevars = SCIPexprtreeGetNVars(gradeval->tree);
+
+    varvals = (SCIP_Real *) malloc(MAX(1, ntreevars) * sizeof(SCIP_Real));
+    treegrad = (SCIP_Real *) malloc(MAX(1, ntreevars) * sizeof(SCIP_Real));
+    if (varvals == NULL || treegrad == NULL)
+    {
+        free(treegrad);
+        free(varvals);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    for (p = 0; p < npoints; ++p)
+    {
+        double *point = &points[(size_t) p * model->nvars];
+        double *grad = &grads[(size_t) p * gradeval->nvars];
+        SCIP_Real val;
+
+        for (i = 0; i < ntreevars; ++i)
+        {
+            varvals[i] = point[gradeval->treevaridx[i]];
+        }
+        SCIP_in_CSIP(SCIPexprintGrad(model->exprint, gradeval->tree, varvals,
+                                     TRUE, &val, treegrad));
+
+        // outside the domain of the expression
+        if (val == SCIP_INVALID)
+        {
+            val = NAN;
+        }
+        vals[p] = val;
+
+        // sum up the partial derivatives of all occurrences of a variable
+        for (i = 0; i < gradeval->nvars; ++i)
+        {
+            grad[i] = 0.0;
+        }
+        for (i = 0; i < ntreevars; ++i)
+        {
+            grad[gradeval->slot[i]] += treegrad[i];
+        }
+    }
+
+    free(treegrad);
+    free(varvals);
+
+    return CSIP_RETCODE_OK;
+}
+
+/*
+ * Callback time budgets
+ */
+
+struct callback_budget
+{
+    double budget;       // seconds per call, or <= 0 for no budget
+    int maxoverruns;     // overruns until we react
+    int recentoverruns;  // overruns since we last reacted
+    double start;        // wall clock time at start of current call
+    CSIP_CALLBACK_STATS stats;
+};
+
+static
+double wallClock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static
+void initBudget(struct callback_budget *budget)
+{
+    budget->budget = 0.0;
+    budget->maxoverruns = 1;
+    budget->recentoverruns = 0;
+    budget->start = 0.0;
+    budget->stats.ncalls = 0;
+    budget->stats.noverruns = 0;
+    budget->stats.totaltime = 0.0;
+    budget->stats.maxtime = 0.0;
+    budget->stats.flagged = 0;
+}
+
+static
+void startBudget(struct callback_budget *budget)
+{
+    budget->start = wallClock();
+}
+
+/* updates statistics after a call and adds its time to timesink; returns
+ * whether the callback has overrun its budget maxoverruns times since the last
+ * time this returned TRUE */
+static
+SCIP_Bool stopBudget(struct callback_budget *budget, double *timesink)
+{
+    double elapsed = wallClock() - budget->start;
+
+    *timesink += elapsed;
+    ++(budget->stats.ncalls);
+    budget->stats.totaltime += elapsed;
+    budget->stats.maxtime = MAX(budget->stats.maxtime, elapsed);
+
+    if (budget->budget <= 0.0 || elapsed <= budget->budget)
+    {
+        return FALSE;
+    }
+
+    ++(budget->stats.noverruns);
+    ++(budget->recentoverruns);
+    if (budget->recentoverruns < budget->maxoverruns)
+    {
+        return FALSE;
+    }
+    budget->recentoverruns = 0;
+
+    return TRUE;
+}
+
+static
+int shouldStop(CSIP_MODEL *model, struct callback_budget *budget)
+{
+    if (SCIPisStopped(model->scip))
+    {
+        return 1;
+    }
+    return budget->budget > 0.0 && wallClock() - budget->start > budget->budget;
+}
+
+/*
+ * Constraint Handler
+ */
+
+/* constraint handler data */
+struct SCIP_ConshdlrData
+{
+    CSIP_MODEL *model;
+    CSIP_LAZYCALLBACK callback;
+    void *userdata;
+    SCIP_Bool checkonly;
+    SCIP_Bool feasible;
+    SCIP_SOL *sol;
+    struct callback_budget budget;
+};
+
+/* lazy constraints can not be skipped, so overruns are only reported */
+static
+void stopLazyBudget(SCIP *scip, SCIP_CONSHDLR *conshdlr,
+                    SCIP_CONSHDLRDATA *conshdlrdata)
+{
+    if (stopBudget(&conshdlrdata->budget, &conshdlrdata->model->metrics.lazytime)
+            && !conshdlrdata->budget.stats.flagged)
+    {
+        conshdlrdata->budget.stats.flagged = 1;
+        SCIPwarningMessage(scip, "%s exceeded its time budget of %g seconds %d "
+                           "times\n", SCIPconshdlrGetName(conshdlr),
+                           conshdlrdata->budget.budget,
+                           conshdlrdata->budget.stats.noverruns);
+    }
+}
+
+SCIP_DECL_CONSFREE(consFreeLazy)
+{
+    SCIP_CONSHDLRDATA *conshdlrdata;
+
+    conshdlrdata = SCIPconshdlrGetData(conshdlr);
+    assert(conshdlrdata != NULL);
+
+    SCIPfreeMemory(scip, &conshdlrdata);
+
+    SCIPconshdlrSetData(conshdlr, NULL);
+
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSENFOLP(consEnfolpLazy)
+{
+    SCIP_CONSHDLRDATA *conshdlrdata;
+
+    *result = SCIP_FEASIBLE;
+
+    conshdlrdata = SCIPconshdlrGetData(conshdlr);
+    conshdlrdata->checkonly = FALSE;
+    conshdlrdata->feasible = TRUE;
+
+    CSIP_PROBE2(lazy__start, conshdlrdata->model, 0);
+    startBudget(&conshdlrdata->budget);
+    CSIP_in_SCIP(conshdlrdata->callback(conshdlrdata->model,
+                                        conshdlrdata, conshdlrdata->userdata));
+    stopLazyBudget(scip, conshdlr, conshdlrdata);
+    CSIP_PROBE2(lazy__done, conshdlrdata->model, (int) conshdlrdata->feasible);
+
+    if (!conshdlrdata->feasible)
+    {
+        *result = SCIP_CONSADDED;
+    }
+
+    return SCIP_OKAY;
+}
+
+/* enfo pseudo solution just call enfo lp solution */
+SCIP_DECL_CONSENFOPS(consEnfopsLazy)
+{
+    return consEnfolpLazy(scip, conshdlr, conss, nconss, nusefulconss,
+                          solinfeasible, result);
+}
+
+/* check callback */
+SCIP_DECL_CONSCHECK(consCheckLazy)
+{
+    SCIP_CONSHDLRDATA *conshdlrdata;
+
+    *result = SCIP_FEASIBLE;
+
+    conshdlrdata = SCIPconshdlrGetData(conshdlr);
+    conshdlrdata->checkonly = TRUE;
+    conshdlrdata->feasible = TRUE;
+    conshdlrdata->sol = sol;
+
+    CSIP_PROBE2(lazy__start, conshdlrdata->model, 1);
+    startBudget(&conshdlrdata->budget);
+    CSIP_in_SCIP(conshdlrdata->callback(conshdlrdata->model,
+                                        conshdlrdata, conshdlrdata->userdata));
+    stopLazyBudget(scip, conshdlr, conshdlrdata);
+    CSIP_PROBE2(lazy__done, conshdlrdata->model, (int) conshdlrdata->feasible);
+
+    if (!conshdlrdata->feasible)
+    {
+        *result = SCIP_INFEASIBLE;
+    }
+
+    return SCIP_OKAY;
+}
+
+/* locks callback */
+SCIP_DECL_CONSLOCK(consLockLazy)
+{
+    int i;
+    SCIP_VAR *var;
+    SCIP_CONSHDLRDATA *conshdlrdata;
+
+    conshdlrdata = SCIPconshdlrGetData(conshdlr);
+
+    assert(scip == conshdlrdata->model->scip);
+
+    for (i = 0; i < conshdlrdata->model->nvars; ++i)
+    {
+        var = conshdlrdata->model->vars[i];
+        SCIP_CALL(SCIPaddVarLocks(scip, var, nlockspos + nlocksneg,
+                                  nlockspos + nlocksneg));
+    }
+
+    return SCIP_OKAY;
+}
+
+/*
+ * callback methods
+ */
+
+CSIP_RETCODE CSIPaddLazyCallback(CSIP_MODEL *model, CSIP_LAZYCALLBACK callback,
+                                 void *userdata)
+{
+    SCIP_CONSHDLRDATA *conshdlrdata;
+    SCIP_CONSHDLR *conshdlr;
+    SCIP *scip;
+    char name[SCIP_MAXSTRLEN];
+    int enfopriority;
+    int checkpriority;
+    int eagerfreq;
+    SCIP_Bool needscons = FALSE;
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDLAZYCALLBACK);
+        recordEnd(model);
+    }
+
+    scip = model->scip;
+
+    /* cons_integral has enfo priority 0 and we want to be checked before */
+    enfopriority = 1;
+    /* we want to be checked as rarely as possible.
+     * -5000000 is the smallest proper value in SCIP's conshdlrs. */
+    checkpriority = -5000000 - 1;
+    /* no eager evaluations?! */
+    eagerfreq = -1;
+
+    SCIP_in_CSIP(SCIPallocMemory(scip, &conshdlrdata));
+
+    conshdlrdata->model = model;
+    conshdlrdata->callback = callback;
+    conshdlrdata->userdata = userdata;
+    initBudget(&conshdlrdata->budget);
+
+    SCIPsnprintf(name, SCIP_MAXSTRLEN, "lazycons_%d", model->nlazycb);
+    SCIP_in_CSIP(SCIPincludeConshdlrBasic(
+                     scip, &conshdlr, name, "lazy constraint callback",
+                     enfopriority, checkpriority, eagerfreq, needscons,
+                     consEnfolpLazy, consEnfopsLazy, consCheckLazy, consLockLazy,
+                     conshdlrdata));
+
+    SCIP_in_CSIP(SCIPsetConshdlrFree(scip, conshdlr, consFreeLazy));
+    model->nlazycb += 1;
+
+    return CSIP_RETCODE_OK;
+}
+
+static
+CSIP_RETCODE isSolIntegral(SCIP *scip, SCIP_SOL *sol, SCIP_Bool *integral)
+{
+    // inspired by consCheckIntegral in cons_integral.c
+    SCIP_VAR **vars;
+    SCIP_Real solval;
+    int nbin, nint, nimpl, nallinteger;
+
+    SCIP_in_CSIP(SCIPgetSolVarsData(scip, sol, &vars, NULL,
+                                    &nbin, &nint, &nimpl, NULL));
+
+    *integral = TRUE;
+    nallinteger = nbin + nint + nimpl;
+    for (int v = 0; v < nallinteger; ++v)
+    {
+        solval = SCIPgetSolVal(scip, sol, vars[v]);
+        if (!SCIPisFeasIntegral(scip, solval))
+        {
+            *integral = FALSE;
+            break;
+        }
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+
+CSIP_LAZY_CONTEXT CSIPlazyGetContext(CSIP_LAZYDATA *lazydata)
+{
+    SCIP_Bool check = lazydata->checkonly;
+    SCIP_SOL *sol = check ? lazydata->sol : NULL;
+    SCIP_Bool integral = FALSE;
+    CSIP_CALL(isSolIntegral(lazydata->model->scip, sol, &integral));
+
+    if (integral)
+    {
+        return CSIP_LAZY_INTEGRALSOL;
+    }
+    else if (!check)
+    {
+        return CSIP_LAZY_LPRELAX;
+    }
+    else
+    {
+        return CSIP_LAZY_OTHER;
+    }
+}
+
+int CSIPlazyShouldStop(CSIP_LAZYDATA *lazydata)
+{
+    return shouldStop(lazydata->model, &lazydata->budget);
+}
+
+/* returns LP or given solution depending whether we are called from check or enfo */
+CSIP_RETCODE CSIPlazyGetVarValues(CSIP_LAZYDATA *lazydata, double *output)
+{
+    int i;
+    SCIP *scip;
+    SCIP_VAR *var;
+    SCIP_SOL *sol;
+
+    scip = lazydata->model->scip;
+    sol = lazydata->checkonly ? lazydata->sol : NULL;
+
+    for (i = 0; i < lazydata->model->nvars; ++i)
+    {
+        var = lazydata->model->vars[i];
+        output[i] = SCIPgetSolVal(scip, sol, var);
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPlazyAddLinCons(CSIP_LAZYDATA *lazydata, int numindices,
+                                int *indices,
+                                double *coefs, double lhs, double rhs, int islocal)
+{
+    SCIP *scip;
+    SCIP_CONS *cons;
+    SCIP_SOL *sol;
+    SCIP_RESULT result;
+
+    scip = lazydata->model->scip;
+
+    if (lazydata->model->recording != NULL)
+    {
+        recordOp(lazydata->model, RECORD_LAZYCONS);
+        recordInts(lazydata->model, numindices, indices);
+        recordDoubles(lazydata->model, numindices, coefs);
+        recordDouble(lazydata->model, lhs);
+        recordDouble(lazydata->model, rhs);
+        recordInt(lazydata->model, islocal);
+        recordEnd(lazydata->model);
+    }
+
+    if (lazydata->checkonly)
+    {
+        sol = lazydata->sol;
+    }
+    else
+    {
+        sol = NULL;
+    }
+
+    /* Is it reasonable to assume that if we solved the problem, then the lazy constraint
+     * is satisfied in the original problem? We get the error:
+     * "method <SCIPcreateCons> cannot be called in the solved stage"
+     * and I am guessing this is because SCIP is checking whether the solution found in the
+     * presolved problem is feasible for the original problem. It could happen it is not feasible
+     * because of numerics mainly, hence the question in the comment
+     */
+    if (SCIPgetStage(scip) == SCIP_STAGE_SOLVED)
+    {
+        assert(lazydata->checkonly);
+        lazydata->feasible = TRUE; /* to be very explicit */
+        return CSIP_RETCODE_OK;
+    }
+
+    if (SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMED)
+    {
+        // we can't even create a cons in this stage, we trust the user's judgement
+        lazydata->feasible = FALSE;
+        return CSIP_RETCODE_OK;
+    }
+
+    CSIP_CALL(createLinCons(lazydata->model, numindices, indices, coefs, lhs, rhs,
+                            &cons));
+    SCIP_in_CSIP(SCIPsetConsLocal(scip, cons, islocal == 1));
+    SCIP_in_CSIP(SCIPcheckCons(scip, cons, sol, FALSE, FALSE, FALSE, &result));
+
+    if (result == SCIP_INFEASIBLE)
+    {
+        lazydata->feasible = FALSE;
+    }
+
+    /* can not add constraints here */
+    if (SCIPgetStage(scip) == SCIP_STAGE_INIT
+            || SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMING
+            || SCIPgetStage(scip) == SCIP_STAGE_INITSOLVE)
+    {
+        assert(lazydata->checkonly);
+        SCIP_in_CSIP(SCIPreleaseCons(lazydata->model->scip, &cons));
+        return CSIP_RETCODE_OK;
+    }
+
+    /* we do not store cons, because the original problem does not contain them;
+     * and there is an issue when freeTransform is called
+     */
+    CSIP_PROBE3(lazy__addcons, lazydata->model, numindices, islocal);
+    ++(lazydata->model->metrics.lazyconss);
+    SCIP_in_CSIP(SCIPaddCons(scip, cons));
+    SCIP_in_CSIP(SCIPreleaseCons(lazydata->model->scip, &cons));
+
+    return CSIP_RETCODE_OK;
+}
+
+/* Heuristic Plugin */
+
+struct SCIP_HeurData
+{
+    CSIP_MODEL *model;
+    CSIP_HEURCALLBACK callback;
+    void *userdata;
+    SCIP_HEUR *heur;
+    unsigned int stored_sols;
+    struct callback_budget budget;
+};
+
+static
+SCIP_DECL_HEURFREE(heurFreeUser)
+{
+    SCIP_HEURDATA *heurdata;
+
+    heurdata = SCIPheurGetData(heur);
+    assert(heurdata != NULL);
+
+    SCIPfreeMemory(scip, &heurdata);
+    SCIPheurSetData(heur, NULL);
+
+    return SCIP_OKAY;
+}
+
+static
+SCIP_DECL_HEUREXEC(heurExecUser)
+{
+    SCIP_HEURDATA *heurdata = SCIPheurGetData(heur);
+    assert(heurdata != NULL);
+
+    *result = SCIP_DIDNOTFIND;
+    heurdata->stored_sols = 0;
+
+    CSIP_PROBE1(heur__start, heurdata->model);
+    startBudget(&heurdata->budget);
+    CSIP_in_SCIP(heurdata->callback(heurdata->model, heurdata,
+                                    heurdata->userdata));
+    CSIP_PROBE2(heur__done, heurdata->model, (int) heurdata->stored_sols);
+
+    // too slow: call it half as often from now on
+    if (stopBudget(&heurdata->budget, &heurdata->model->metrics.heurtime)
+            && SCIPheurGetFreq(heur) > 0)
+    {
+        heurdata->budget.stats.flagged = 1;
+        SCIPheurSetFreq(heur, 2 * SCIPheurGetFreq(heur));
+    }
+
+    if (heurdata->stored_sols > 0)
+    {
+        *result = SCIP_FOUNDSOL;
+    }
+
+    return SCIP_OKAY;
+}
+
+int CSIPheurShouldStop(CSIP_HEURDATA *heurdata)
+{
+    return shouldStop(heurdata->model, &heurdata->budget);
+}
+
+// Copy values of solution to output array. Call this function from your
+// heuristic callback. Solution is LP relaxation of current node.
+CSIP_RETCODE CSIPheurGetVarValues(CSIP_HEURDATA *heurdata, double *output)
+{
+    CSIP_MODEL *model = heurdata->model;
+    SCIP_in_CSIP(SCIPgetSolVals(model->scip, NULL, model->nvars, model->vars,
+                                output));
+    return CSIP_RETCODE_OK;
+}
+
+// Supply a solution (as a dense array). Only complete solutions are supported.
+CSIP_RETCODE CSIPheurAddSolution(CSIP_HEURDATA *heurdata, double *values)
+{
+    SCIP_SOL *sol;
+    CSIP_MODEL *model = heurdata->model;
+    SCIP *scip = model->scip;
+    unsigned int stored = 0;
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_HEURSOL);
+        recordDoubles(model, model->nvars, values);
+        recordEnd(model);
+    }
+
+    SCIP_in_CSIP(SCIPcreateSol(scip, &sol, heurdata->heur));
+    SCIP_in_CSIP(SCIPsetSolVals(scip, sol, model->nvars, model->vars, values));
+    SCIP_in_CSIP(SCIPtrySolFree(scip, &sol, FALSE, FALSE, TRUE, TRUE, TRUE, &stored));
+    CSIP_PROBE2(heur__addsol, model, (int) stored);
+
+    if (stored > 0)
+    {
+        heurdata->stored_sols += 1;
+    }
+
+    return CSIP_RETCODE_OK;
+}
+
+// Add a heuristic callback to the model.
+// You may use userdata to pass any data.
+CSIP_RETCODE CSIPaddHeuristicCallback(
+    CSIP_MODEL *model, CSIP_HEURCALLBACK callback, void *userdata)
+{
+    SCIP_HEURDATA *heurdata;
+    SCIP_HEUR *heur;
+    SCIP *scip;
+    char name[SCIP_MAXSTRLEN];
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_ADDHEURCALLBACK);
+        recordEnd(model);
+    }
+
+    scip = model->scip;
+
+    SCIP_in_CSIP(SCIPallocMemory(scip, &heurdata));
+
+    SCIPsnprintf(name, SCIP_MAXSTRLEN, "heur_%d", model->nheur);
+    SCIP_in_CSIP(SCIPincludeHeurBasic(
+                     scip, &heur, name, "heuristic callback", 'x',
+                     1, 1, 0, -1, SCIP_HEURTIMING_AFTERNODE, FALSE,
+                     heurExecUser, heurdata));
+    heurdata->model = model;
+    heurdata->callback = callback;
+    heurdata->userdata = userdata;
+    heurdata->heur = heur;
+    heurdata->stored_sols = 0;
+    initBudget(&heurdata->budget);
+
+    SCIP_in_CSIP(SCIPsetHeurFree(scip, heur, heurFreeUser));
+    model->nheur += 1;
+
+    return CSIP_RETCODE_OK;
+}
+
+static
+CSIP_RETCODE getCallbackBudget(CSIP_MODEL *model, CSIP_CALLBACKTYPE type,
+                               int cbidx, struct callback_budget **budget)
+{
+    char name[SCIP_MAXSTRLEN];
+
+    if (type == CSIP_CALLBACKTYPE_LAZY && cbidx >= 0 && cbidx < model->nlazycb)
+    {
+        SCIPsnprintf(name, SCIP_MAXSTRLEN, "lazycons_%d", cbidx);
+        *budget = &SCIPconshdlrGetData(SCIPfindConshdlr(model->scip,
+                                       name))->budget;
+        return CSIP_RETCODE_OK;
+    }
+    if (type == CSIP_CALLBACKTYPE_HEURISTIC && cbidx >= 0 && cbidx < model->nheur)
+    {
+        SCIPsnprintf(name, SCIP_MAXSTRLEN, "heur_%d", cbidx);
+        *budget = &SCIPheurGetData(SCIPfindHeur(model->scip, name))->budget;
+        return CSIP_RETCODE_OK;
+    }
+
+    return CSIP_RETCODE_ERROR;
+}
+
+CSIP_RETCODE CSIPsetCallbackBudget(
+    CSIP_MODEL *model, CSIP_CALLBACKTYPE type, int cbidx, double timebudget,
+    int maxoverruns)
+{
+    struct callback_budget *budget;
+
+    if (getCallbackBudget(model, type, cbidx, &budget) != CSIP_RETCODE_OK
+            || maxoverruns < 1)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_SETCALLBACKBUDGET);
+        recordInt(model, type);
+        recordInt(model, cbidx);
+        recordDouble(model, timebudget);
+        recordInt(model, maxoverruns);
+        recordEnd(model);
+    }
+
+    budget->budget = timebudget;
+    budget->maxoverruns = maxoverruns;
+    budget->recentoverruns = 0;
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPgetCallbackStats(
+    CSIP_MODEL *model, CSIP_CALLBACKTYPE type, int cbidx,
+    CSIP_CALLBACK_STATS *stats)
+{
+    struct callback_budget *budget;
+
+    if (getCallbackBudget(model, type, cbidx, &budget) != CSIP_RETCODE_OK)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    *stats = budget->stats;
+
+    return CSIP_RETCODE_OK;
+}
 
-    scip = model->scip;
-    SCIP_in_CSIP(SCIPfreeTransform(scip));
+/*
+ * Parallel tasks
+ */
 
-    // create nonlinear objective constraint
-    SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(scip, &cons,
-                 "nonlin_obj", 0, NULL, NULL, 1, &tree, NULL,
-                 -SCIPinfinity(scip), 0.0));
+typedef CSIP_RETCODE(*CSIP_TASK)(void *data, int task, int worker);
 
-    // add objvar to nonlinear objective
-    if (model->objvar != NULL)
-    {
-        SCIP_in_CSIP(SCIPchgVarObj(scip, model->objvar, 0.0));
-        SCIP_in_CSIP(SCIPchgVarLb(scip, model->objvar, -SCIPinfinity(scip)));
-        SCIP_in_CSIP(SCIPchgVarUb(scip, model->objvar, SCIPinfinity(scip)));
+struct parallel_for
+{
+    CSIP_TASK taskfn;
+    void *data;
+    int ntasks;
+    int next;
+    CSIP_RETCODE retcode;
+    pthread_mutex_t lock;
+};
 
-        // we do not need to remember this variable anymore nor objcons
-        SCIP_in_CSIP(SCIPreleaseVar(scip, &model->objvar));
-        SCIP_in_CSIP(SCIPreleaseCons(scip, &model->objcons));
-    }
-    assert(model->objvar == NULL);
-    assert(model->objcons == NULL);
+struct parallel_worker
+{
+    struct parallel_for *pf;
+    int worker;
+};
 
-    SCIP_in_CSIP(SCIPcreateVarBasic(scip, &model->objvar, NULL,
-                                    -SCIPinfinity(scip), SCIPinfinity(scip), 1.0,
-                                    SCIP_VARTYPE_CONTINUOUS));
-    SCIP_in_CSIP(SCIPaddVar(scip, model->objvar));
-    SCIP_in_CSIP(SCIPaddLinearVarNonlinear(scip, cons, model->objvar, -1.0));
+// process-wide executor, see CSIPsetGlobalExecutor
+static CSIP_EXECUTOR globalexecutor;
+static SCIP_Bool hasglobalexecutor = FALSE;
+static pthread_mutex_t executorlock = PTHREAD_MUTEX_INITIALIZER;
 
-    // add objective constraint and remember it
-    SCIP_in_CSIP(SCIPaddCons(scip, cons));
-    model->objcons = cons;
-    model->objtype = CSIP_OBJTYPE_NONLINEAR;
+// CPU set of a worker; returns FALSE if the worker may run anywhere
+static
+SCIP_Bool getWorkerCPUs(struct cpu_sets *cpusets, int worker, cpu_set_t *set)
+{
+    int s;
 
-    // the created constraint is correct if sense is minimize, otherwise we
-    // have to correct it
-    if (SCIPgetObjsense(model->scip) == SCIP_OBJSENSE_MAXIMIZE)
+    if (cpusets == NULL || cpusets->nsets == 0)
     {
-        CSIP_CALL(correctObjectiveFunction(model));
+        return FALSE;
     }
 
-    // free memory
-    SCIP_in_CSIP(SCIPexprtreeFree(&tree));
+    s = worker % cpusets->nsets;
+    CPU_ZERO(set);
+    for (int i = cpusets->beg[s]; i < cpusets->beg[s + 1]; ++i)
+    {
+        CPU_SET(cpusets->cpus[i], set);
+    }
 
-    return CSIP_RETCODE_OK;
+    return TRUE;
 }
 
-CSIP_RETCODE CSIPsetSenseMinimize(CSIP_MODEL *model)
+// take tasks from the shared counter until none are left or one failed
+static
+void *parallelWorker(void *arg)
 {
-    SCIP_in_CSIP(SCIPfreeTransform(model->scip));
+    struct parallel_worker *pw = (struct parallel_worker *) arg;
+    struct parallel_for *pf = pw->pf;
 
-    if (SCIPgetObjsense(model->scip) != SCIP_OBJSENSE_MINIMIZE)
+    for (;;)
     {
-        SCIP_in_CSIP(SCIPsetObjsense(model->scip, SCIP_OBJSENSE_MINIMIZE));
-        CSIP_CALL(correctObjectiveFunction(model));
+        CSIP_RETCODE retcode;
+        int task;
+
+        pthread_mutex_lock(&pf->lock);
+        task = pf->retcode == CSIP_RETCODE_OK ? pf->next++ : pf->ntasks;
+        pthread_mutex_unlock(&pf->lock);
+        if (task >= pf->ntasks)
+        {
+            break;
+        }
+
+        retcode = pf->taskfn(pf->data, task, pw->worker);
+        if (retcode != CSIP_RETCODE_OK)
+        {
+            pthread_mutex_lock(&pf->lock);
+            pf->retcode = retcode;
+            pthread_mutex_unlock(&pf->lock);
+        }
     }
 
-    return CSIP_RETCODE_OK;
+    return NULL;
 }
 
-CSIP_RETCODE CSIPsetSenseMaximize(CSIP_MODEL *model)
+// executor job of a worker
+static
+void executorJob(void *arg)
 {
-    SCIP_in_CSIP(SCIPfreeTransform(model->scip));
+    parallelWorker(arg);
+}
 
-    if (SCIPgetObjsense(model->scip) != SCIP_OBJSENSE_MAXIMIZE)
+// executor for the parallel work of model; returns FALSE if there is none
+static
+SCIP_Bool getExecutor(CSIP_MODEL *model, CSIP_EXECUTOR *executor)
+{
+    SCIP_Bool found;
+
+    if (model->hasexecutor)
     {
-        SCIP_in_CSIP(SCIPsetObjsense(model->scip, SCIP_OBJSENSE_MAXIMIZE));
-        CSIP_CALL(correctObjectiveFunction(model));
+        *executor = model->executor;
+        return TRUE;
     }
 
-    return CSIP_RETCODE_OK;
+    pthread_mutex_lock(&executorlock);
+    found = hasglobalexecutor;
+    *executor = globalexecutor;
+    pthread_mutex_unlock(&executorlock);
+
+    return found;
 }
 
-CSIP_RETCODE CSIPsolve(CSIP_MODEL *model)
+// run taskfn(data, task, worker) for task = 0..ntasks-1 on nworkers workers,
+// the calling thread being worker 0. The other workers are jobs of the
+// executor of model, if it has one, or threads pinned to the CPU sets of
+// model, if given; they should allocate their data themselves, so that it is
+// placed on their NUMA node (first touch).
+static
+CSIP_RETCODE parallelFor(int ntasks, int nworkers, CSIP_MODEL *model,
+                         CSIP_TASK taskfn, void *data)
 {
-    // add initial solution
-    if (model->initialsol != NULL)
+    struct parallel_for pf;
+    struct parallel_worker *workers;
+    struct cpu_sets *cpusets = &model->workercpus;
+    CSIP_EXECUTOR executor;
+    SCIP_Bool useexecutor;
+    pthread_t *threads;
+    void **handles;
+    pthread_attr_t attr;
+    cpu_set_t set;
+    cpu_set_t callerset;
+    SCIP_Bool pincaller;
+    int nthreads;
+    int t;
+
+    pf.taskfn = taskfn;
+    pf.data = data;
+    pf.ntasks = ntasks;
+    pf.next = 0;
+    pf.retcode = CSIP_RETCODE_OK;
+    nworkers = MAX(1, nworkers);
+
+    useexecutor = getExecutor(model, &executor);
+    if (useexecutor && executor.concurrency != NULL)
     {
-        unsigned int stored;
-        SCIP_Bool initialsolpartial =
-            (SCIPsolGetOrigin(model->initialsol) == SCIP_SOLORIGIN_PARTIAL);
+        int concurrency = executor.concurrency(executor.executordata);
 
-        /* if objective is nonlinear, we need to extend the initial sol with
-         * the value of objvar. For this we need to change the objective
-         * constraint temporarily to an equality constraint. However the
-         * nonlinear contraint handler doesn't allow to change sides, so
-         * we have to create a brand new constraint to compute the violation
-         *
-         * This is not true if the user has given a partial sol, because then
-         * we can safely leave the value for the objval unspecified. In fact,
-         * that's preferred, because computing the violation might fail.
-         */
-        if (model->objcons != NULL && !initialsolpartial)
+        if (concurrency > 0)
         {
-            SCIP_CONS* tempcons;
-            SCIP_Real objvarval;
-            SCIP_EXPRTREE *tree;
+            nworkers = MIN(nworkers, concurrency);
+        }
+    }
 
-            /* we do not care about the sign of the expression tree, since
-             * tempcons is equality and this already gives the correct sign for
-             * objvarval */
-            tree = SCIPgetExprtreesNonlinear(model->scip, model->objcons)[0];
-            SCIP_in_CSIP(SCIPcreateConsBasicNonlinear(model->scip, &tempcons,
-                     "temp_nonlin_obj", 0, NULL, NULL, 1, &tree, NULL,
-                     0.0, 0.0));
-            SCIP_in_CSIP(SCIPgetViolationNonlinear(model->scip, tempcons,
-                     model->initialsol, &objvarval) );
+    workers = (struct parallel_worker *) malloc(nworkers * sizeof(
+                  struct parallel_worker));
+    threads = (pthread_t *) malloc(nworkers * sizeof(pthread_t));
+    handles = (void **) malloc(nworkers * sizeof(void *));
+    if (workers == NULL || threads == NULL || handles == NULL)
+    {
+        free(handles);
+        free(threads);
+        free(workers);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    pthread_mutex_init(&pf.lock, NULL);
 
-            SCIP_in_CSIP(SCIPreleaseCons(model->scip, &tempcons));
+    // if we can't get more workers, the ones we have will do all tasks
+    for (nthreads = 1; nthreads < nworkers; ++nthreads)
+    {
+        SCIP_Bool pinned;
+        int created;
 
-            SCIP_in_CSIP(SCIPsetSolVals(model->scip, model->initialsol, 1,
-                     &model->objvar, &objvarval));
+        workers[nthreads].pf = &pf;
+        workers[nthreads].worker = nthreads;
+        if (useexecutor)
+        {
+            handles[nthreads] = executor.submit(executor.executordata,
+                                                executorJob, &workers[nthreads]);
+            if (handles[nthreads] == NULL)
+            {
+                break;
+            }
+            continue;
         }
 
+        pthread_attr_init(&attr);
+        pinned = FALSE;
+        if (getWorkerCPUs(cpusets, nthreads, &set))
+        {
+            pinned = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t),
+                                                 &set) == 0;
+            if (!pinned)
+            {
+                SCIPwarningMessage(model->scip, "could not pin worker %d to "
+                                   "its CPU set\n", nthreads);
+            }
+        }
+        created = pthread_create(&threads[nthreads], &attr, parallelWorker,
+                                 &workers[nthreads]);
+        pthread_attr_destroy(&attr);
 
-        SCIP_in_CSIP(SCIPaddSolFree(model->scip, &model->initialsol, &stored));
+        // CPUs that are not available make pthread_create fail
+        if (created != 0 && pinned)
+        {
+            SCIPwarningMessage(model->scip, "could not pin worker %d to its "
+                               "CPU set, running it unpinned\n", nthreads);
+            created = pthread_create(&threads[nthreads], NULL, parallelWorker,
+                                     &workers[nthreads]);
+        }
+        if (created != 0)
+        {
+            SCIPwarningMessage(model->scip, "could only start %d of %d "
+                               "workers\n", nthreads, nworkers);
+            break;
+        }
     }
 
-    SCIP_in_CSIP(SCIPsolve(model->scip));
+    // the calling thread is pinned only while it works for us; the executor
+    // places its own threads
+    pincaller = !useexecutor && getWorkerCPUs(cpusets, 0, &set)
+                && pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                          &callerset) == 0;
+    if (pincaller && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                            &set) != 0)
+    {
+        SCIPwarningMessage(model->scip, "could not pin worker 0 to its CPU "
+                           "set\n");
+        pincaller = FALSE;
+    }
+    workers[0].pf = &pf;
+    workers[0].worker = 0;
+    parallelWorker(&workers[0]);
+    if (pincaller)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &callerset);
+    }
 
-    return CSIP_RETCODE_OK;
+    for (t = 1; t < nthreads; ++t)
+    {
+        if (useexecutor)
+        {
+            executor.wait(executor.executordata, handles[t]);
+        }
+        else
+        {
+            pthread_join(threads[t], NULL);
+        }
+    }
+
+    pthread_mutex_destroy(&pf.lock);
+    free(handles);
+    free(threads);
+    free(workers);
+
+    return pf.retcode;
 }
 
-CSIP_RETCODE CSIPinterrupt(CSIP_MODEL *model)
+CSIP_RETCODE CSIPsetGlobalExecutor(CSIP_EXECUTOR *executor)
 {
-    SCIP_in_CSIP(SCIPinterruptSolve(model->scip));
+    if (executor != NULL && (executor->submit == NULL || executor->wait == NULL))
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+
+    pthread_mutex_lock(&executorlock);
+    hasglobalexecutor = (executor != NULL);
+    if (executor != NULL)
+    {
+        globalexecutor = *executor;
+    }
+    pthread_mutex_unlock(&executorlock);
+
     return CSIP_RETCODE_OK;
 }
 
-CSIP_STATUS CSIPgetStatus(CSIP_MODEL *model)
+CSIP_RETCODE CSIPsetExecutor(CSIP_MODEL *model, CSIP_EXECUTOR *executor)
 {
-    switch (SCIPgetStatus(model->scip))
+    if (executor != NULL && (executor->submit == NULL || executor->wait == NULL))
     {
-    case SCIP_STATUS_UNKNOWN:
-        return CSIP_STATUS_UNKNOWN;
-    case SCIP_STATUS_USERINTERRUPT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_NODELIMIT:
-        return CSIP_STATUS_NODELIMIT;
-    case SCIP_STATUS_TOTALNODELIMIT:
-        return CSIP_STATUS_NODELIMIT;
-    case SCIP_STATUS_STALLNODELIMIT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_TIMELIMIT:
-        return CSIP_STATUS_TIMELIMIT;
-    case SCIP_STATUS_MEMLIMIT:
-        return CSIP_STATUS_MEMLIMIT;
-    case SCIP_STATUS_GAPLIMIT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_SOLLIMIT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_BESTSOLLIMIT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_RESTARTLIMIT:
-        return CSIP_STATUS_USERLIMIT;
-    case SCIP_STATUS_OPTIMAL:
-        return CSIP_STATUS_OPTIMAL;
-    case SCIP_STATUS_INFEASIBLE:
-        return CSIP_STATUS_INFEASIBLE;
-    case SCIP_STATUS_UNBOUNDED:
-        return CSIP_STATUS_UNBOUNDED;
-    case SCIP_STATUS_INFORUNBD:
-        return CSIP_STATUS_INFORUNBD;
-    default:
-        return CSIP_STATUS_UNKNOWN;
+        return CSIP_RETCODE_ERROR;
+    }
+
+    model->hasexecutor = (executor != NULL);
+    if (executor != NULL)
+    {
+        model->executor = *executor;
     }
+
+    return CSIP_RETCODE_OK;
 }
 
-double CSIPgetObjValue(CSIP_MODEL *model)
+/*
+ * Parametric right-hand sides
+ */
+
+// change sides of a linear constraint
+static
+CSIP_RETCODE chgLinConsSides(CSIP_MODEL *model, int considx, double lhs,
+                             double rhs)
 {
-    SCIP_SOL *sol = SCIPgetBestSol(model->scip);
-    if (sol == NULL)
+    SCIP *scip = model->scip;
+    SCIP_CONS *cons = model->conss[considx];
+
+    if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "linear") != 0)
     {
         return CSIP_RETCODE_ERROR;
     }
 
-    return SCIPgetSolOrigObj(model->scip, sol);
+    if (model->recording != NULL)
+    {
+        recordOp(model, RECORD_CHGLINCONSSIDES);
+        recordInt(model, considx);
+        recordDouble(model, lhs);
+        recordDouble(model, rhs);
+        recordEnd(model);
+    }
+
+    CSIP_CALL(freeTransform(model));
+
+    // keep lhs <= rhs while moving both sides
+    if (lhs > SCIPgetRhsLinear(scip, cons))
+    {
+        SCIP_in_CSIP(SCIPchgRhsLinear(scip, cons, rhs));
+        SCIP_in_CSIP(SCIPchgLhsLinear(scip, cons, lhs));
+    }
+    else
+    {
+        SCIP_in_CSIP(SCIPchgLhsLinear(scip, cons, lhs));
+        SCIP_in_CSIP(SCIPchgRhsLinear(scip, cons, rhs));
+    }
+
+    return CSIP_RETCODE_OK;
 }
 
-double CSIPgetObjBound(CSIP_MODEL *model)
+CSIP_RETCODE CSIPsweepRHS(
+    CSIP_MODEL *model, int ncons, int *considx, int nsteps, double *rhsvalues,
+    CSIP_SCENARIO_RESULT *results)
 {
-    return SCIPgetDualbound(model->scip);
+    SCIP *scip = model->scip;
+    double *origlhs = (double *) malloc(ncons * sizeof(double));
+    double *origrhs = (double *) malloc(ncons * sizeof(double));
+    double *values = (double *) malloc(model->nvars * sizeof(double));
+    SCIP_Bool hasintegers = FALSE;
+    int step;
+    int c;
+    int i;
+
+    if (origlhs == NULL || origrhs == NULL || values == NULL)
+    {
+        free(values);
+        free(origrhs);
+        free(origlhs);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    for (c = 0; c < ncons; ++c)
+    {
+        SCIP_CONS *cons;
+
+        if (considx[c] < 0 || considx[c] >= model->nconss)
+        {
+            free(values);
+            free(origrhs);
+            free(origlhs);
+            return CSIP_RETCODE_ERROR;
+        }
+        cons = model->conss[considx[c]];
+        if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "linear") != 0)
+        {
+            free(values);
+            free(origrhs);
+            free(origlhs);
+            return CSIP_RETCODE_ERROR;
+        }
+        origlhs[c] = SCIPgetLhsLinear(scip, cons);
+        origrhs[c] = SCIPgetRhsLinear(scip, cons);
+    }
+    for (i = 0; i < model->nvars; ++i)
+    {
+        hasintegers = hasintegers
+                      || CSIPgetVarType(model, i) != CSIP_VARTYPE_CONTINUOUS;
+    }
+
+    for (step = 0; step < nsteps; ++step)
+    {
+        CSIP_SCENARIO_RESULT *result = &results[step];
+
+        // the finite side is changed; both sides of equality constraints
+        for (c = 0; c < ncons; ++c)
+        {
+            double value = rhsvalues[step * ncons + c];
+
+            if (origlhs[c] == origrhs[c])
+            {
+                CSIP_CALL(chgLinConsSides(model, considx[c], value, value));
+            }
+            else if (!SCIPisInfinity(scip, origrhs[c]))
+            {
+                CSIP_CALL(chgLinConsSides(model, considx[c], origlhs[c], value));
+            }
+            else
+            {
+                CSIP_CALL(chgLinConsSides(model, considx[c], value, origrhs[c]));
+            }
+        }
+
+        // warm start from the previous solution: with a repair budget, the
+        // whole solution is given and CSIPsolve repairs it if the new sides
+        // cut it off; otherwise only its integer values are kept and SCIP
+        // completes the continuous ones, or starts without it if no
+        // completion is feasible
+        if (step > 0 && hasintegers && SCIPgetBestSol(scip) != NULL)
+        {
+            CSIP_CALL(CSIPgetVarValues(model, values));
+            for (i = 0; i < model->nvars && model->repairbudget <= 0.0; ++i)
+            {
+                if (CSIPgetVarType(model, i) == CSIP_VARTYPE_CONTINUOUS)
+                {
+                    values[i] = NAN;
+                }
+            }
+            CSIP_CALL(CSIPsetInitialSolution(model, values));
+        }
+
+        CSIP_CALL(CSIPsolve(model));
+
+        result->status = CSIPgetStatus(model);
+        result->objbound = CSIPgetObjBound(model);
+        result->cpu = sched_getcpu();
+        result->objvalue = SCIPgetBestSol(scip) != NULL ? CSIPgetObjValue(model) :
+                           NAN;
+        if (result->values != NULL && SCIPgetBestSol(scip) != NULL)
+        {
+            CSIP_CALL(CSIPgetVarValues(model, result->values));
+        }
+    }
+
+    for (c = 0; c < ncons; ++c)
+    {
+        CSIP_CALL(chgLinConsSides(model, considx[c], origlhs[c], origrhs[c]));
+    }
+
+    free(values);
+    free(origrhs);
+    free(origlhs);
+
+    return CSIP_RETCODE_OK;
 }
 
+/*
+ * Scenario batches
+ */
 
-CSIP_RETCODE CSIPgetVarValues(CSIP_MODEL *model, double *output)
+// create a copy of the original problem of source, with the same indices of
+// variables and constraints, but without callbacks
+static
+CSIP_RETCODE copyModel(CSIP_MODEL *source, CSIP_MODEL **targetptr)
 {
-    int i;
+    CSIP_MODEL *target;
     SCIP *scip;
-    SCIP_VAR *var;
+    SCIP_HASHMAP *varmap;
+    SCIP_HASHMAP *consmap;
+    SCIP_Bool valid;
+    int i;
 
-    scip = model->scip;
+    assert(source->nlazycb == 0 && source->nheur == 0);
 
-    if (SCIPgetBestSol(scip) == NULL)
+    *targetptr = (CSIP_MODEL *)malloc(sizeof(CSIP_MODEL));
+    if (*targetptr == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    target = *targetptr;
+
+    SCIP_in_CSIP(SCIPcreate(&target->scip));
+    scip = target->scip;
+
+    SCIP_in_CSIP(SCIPhashmapCreate(&varmap, SCIPblkmem(scip),
+                                   source->nvars + 1));
+    SCIP_in_CSIP(SCIPhashmapCreate(&consmap, SCIPblkmem(scip),
+                                   source->nconss + 1));
+    // copies solve concurrently, so they must not share a message handler
+    SCIP_in_CSIP(SCIPcopyOrig(source->scip, scip, varmap, consmap, "", FALSE,
+                              FALSE, &valid));
+    if (!valid)
     {
         return CSIP_RETCODE_ERROR;
     }
 
-    for (i = 0; i < model->nvars; ++i)
+    target->nvars = source->nvars;
+    target->varssize = source->varssize;
+    target->vars = (SCIP_VAR **) malloc(target->varssize * sizeof(SCIP_VAR *));
+    if (target->vars == NULL)
     {
-        var = model->vars[i];
-        output[i] = SCIPgetSolVal(scip, SCIPgetBestSol(scip), var);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    for (i = 0; i < target->nvars; ++i)
+    {
+        target->vars[i] = (SCIP_VAR *) SCIPhashmapGetImage(varmap,
+                          source->vars[i]);
+        SCIP_in_CSIP(SCIPcaptureVar(scip, target->vars[i]));
+    }
+
+    target->nobjsupport = source->nobjsupport;
+    target->objsupport = (int *) malloc(target->varssize * sizeof(int));
+    target->inobjsupport = (SCIP_Bool *) malloc(target->varssize * sizeof(
+                               SCIP_Bool));
+    if (target->objsupport == NULL || target->inobjsupport == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    memcpy(target->objsupport, source->objsupport,
+           source->nobjsupport * sizeof(int));
+    memcpy(target->inobjsupport, source->inobjsupport,
+           source->nvars * sizeof(SCIP_Bool));
+
+    target->nconss = source->nconss;
+    target->consssize = source->consssize;
+    target->conss = (SCIP_CONS **) malloc(target->consssize * sizeof(SCIP_CONS *));
+    target->conscurvature = (CSIP_CURVATURE *) malloc(
+                                target->consssize * sizeof(CSIP_CURVATURE));
+    if (target->conss == NULL || target->conscurvature == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    memcpy(target->conscurvature, source->conscurvature,
+           source->nconss * sizeof(CSIP_CURVATURE));
+    target->objcurvature = source->objcurvature;
+    target->assumeconvexset = source->assumeconvexset;
+    target->userassumeconvex = source->userassumeconvex;
+    for (i = 0; i < target->nconss; ++i)
+    {
+        target->conss[i] = (SCIP_CONS *) SCIPhashmapGetImage(consmap,
+                           source->conss[i]);
+        SCIP_in_CSIP(SCIPcaptureCons(scip, target->conss[i]));
+    }
+
+    target->objvar = NULL;
+    target->objcons = NULL;
+    if (source->objvar != NULL)
+    {
+        target->objvar = (SCIP_VAR *) SCIPhashmapGetImage(varmap,
+                         source->objvar);
+        target->objcons = (SCIP_CONS *) SCIPhashmapGetImage(consmap,
+                          source->objcons);
+        SCIP_in_CSIP(SCIPcaptureVar(scip, target->objvar));
+        SCIP_in_CSIP(SCIPcaptureCons(scip, target->objcons));
     }
+    target->objtype = source->objtype;
+
+    target->nlazycb = 0;
+    target->nheur = 0;
+    target->initialsol = NULL;
+    target->repairbudget = source->repairbudget;
+    target->initialsolstatus = CSIP_INITSOL_NONE;
+    target->msghdlr = NULL;
+    if (getMessagePrefix(source) != NULL)
+    {
+        CSIP_CALL(setPrefixMessagehdlr(target, getMessagePrefix(source)));
+    }
+    target->benders = NULL;
+    target->recording = NULL;
+    target->replay = NULL;
+    target->workercpus.nsets = 0;
+    target->hasexecutor = FALSE;
+    target->workercpus.beg = NULL;
+    target->workercpus.cpus = NULL;
+    target->deterministic = source->deterministic;
+    resetModelMetrics(target);
+    target->ntemplates = 0;
+    target->templatessize = 0;
+    target->templates = NULL;
+    target->nbasevalues = 0;
+    target->basevalues = NULL;
+    target->basetolerance = source->basetolerance;
+    target->ngradevals = 0;
+    target->gradevals = NULL;
+    target->objgradeval.tree = NULL;
+    target->exprint = NULL;
+    target->nvarindex = 0;
+    target->varindex = NULL;
+    pthread_mutex_init(&target->progresslock, NULL);
+    resetProgress(target);
+    CSIP_CALL(includeProgressEventhdlr(target));
+
+    SCIPhashmapFree(&consmap);
+    SCIPhashmapFree(&varmap);
 
     return CSIP_RETCODE_OK;
 }
 
-// Get the type of a parameter
-CSIP_PARAMTYPE CSIPgetParamType(CSIP_MODEL *model, const char *name)
+// set bounds, sides and objective coefficients given in delta; with revert,
+// set them back to the values of base instead
+static
+CSIP_RETCODE applyScenario(CSIP_MODEL *model, CSIP_MODEL *base,
+                           CSIP_SCENARIO *delta, SCIP_Bool revert)
 {
-    SCIP_PARAM *param;
+    SCIP *scip = model->scip;
+    int i;
 
-    param = SCIPgetParam(model->scip, name);
-    if (param == NULL)
+    CSIP_CALL(freeTransform(model));
+
+    for (i = 0; i < delta->nbounds; ++i)
     {
-        return CSIP_PARAMTYPE_NOTAPARAM;
+        int idx = delta->boundindices[i];
+        SCIP_VAR *basevar = base->vars[idx];
+
+        if (delta->lowerbounds != NULL)
+        {
+            SCIP_in_CSIP(SCIPchgVarLb(scip, model->vars[idx], revert ?
+                                      SCIPvarGetLbOriginal(basevar) : delta->lowerbounds[i]));
+        }
+        if (delta->upperbounds != NULL)
+        {
+            SCIP_in_CSIP(SCIPchgVarUb(scip, model->vars[idx], revert ?
+                                      SCIPvarGetUbOriginal(basevar) : delta->upperbounds[i]));
+        }
     }
-    else
+
+    for (i = 0; i < delta->nsides; ++i)
     {
-        return SCIPparamGetType(param);
+        int idx = delta->consindices[i];
+        SCIP_CONS *cons = model->conss[idx];
+        SCIP_CONS *basecons = base->conss[idx];
+        double lhs = SCIPgetLhsLinear(scip, cons);
+        double rhs = SCIPgetRhsLinear(scip, cons);
+
+        if (revert)
+        {
+            lhs = SCIPgetLhsLinear(base->scip, basecons);
+            rhs = SCIPgetRhsLinear(base->scip, basecons);
+        }
+        else
+        {
+            lhs = delta->lhs != NULL ? delta->lhs[i] : lhs;
+            rhs = delta->rhs != NULL ? delta->rhs[i] : rhs;
+        }
+        CSIP_CALL(chgLinConsSides(model, idx, lhs, rhs));
     }
-}
 
-CSIP_RETCODE CSIPsetBoolParam(
-    CSIP_MODEL *model, const char *name, int value)
-{
-    SCIP_in_CSIP(SCIPsetBoolParam(model->scip, name, value));
-    return CSIP_RETCODE_OK;
-}
+    for (i = 0; i < delta->nobj; ++i)
+    {
+        int idx = delta->objindices[i];
+        CSIP_CALL(setVarObj(model, idx, revert ?
+                            SCIPvarGetObj(base->vars[idx]) : delta->objcoefs[i]));
+    }
 
-CSIP_RETCODE CSIPsetIntParam(
-    CSIP_MODEL *model, const char *name, int value)
-{
-    SCIP_in_CSIP(SCIPsetIntParam(model->scip, name, value));
     return CSIP_RETCODE_OK;
 }
 
-CSIP_RETCODE CSIPsetLongintParam(
-    CSIP_MODEL *model, const char *name, long long value)
+// indices of delta must be valid in base, and changed sides must be those of
+// linear constraints and stay ordered
+static
+CSIP_RETCODE checkScenario(CSIP_MODEL *base, CSIP_SCENARIO *delta)
 {
-    SCIP_in_CSIP(SCIPsetLongintParam(model->scip, name, value));
-    return CSIP_RETCODE_OK;
-}
+    int i;
 
-CSIP_RETCODE CSIPsetRealParam(
-    CSIP_MODEL *model, const char *name, double value)
-{
-    SCIP_in_CSIP(SCIPsetRealParam(model->scip, name, value));
-    return CSIP_RETCODE_OK;
-}
+    for (i = 0; i < delta->nbounds; ++i)
+    {
+        if (delta->boundindices[i] < 0 || delta->boundindices[i] >= base->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
 
-CSIP_RETCODE CSIPsetCharParam(
-    CSIP_MODEL *model, const char *name, char value)
-{
-    SCIP_in_CSIP(SCIPsetCharParam(model->scip, name, value));
-    return CSIP_RETCODE_OK;
-}
+    for (i = 0; i < delta->nsides; ++i)
+    {
+        int idx = delta->consindices[i];
+        SCIP_CONS *cons;
+        double lhs;
+        double rhs;
+
+        if (idx < 0 || idx >= base->nconss)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        cons = base->conss[idx];
+        if (strcmp(SCIPconshdlrGetName(SCIPconsGetHdlr(cons)), "linear") != 0)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        lhs = delta->lhs != NULL ? delta->lhs[i] :
+              SCIPgetLhsLinear(base->scip, cons);
+        rhs = delta->rhs != NULL ? delta->rhs[i] :
+              SCIPgetRhsLinear(base->scip, cons);
+        if (lhs > rhs)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    for (i = 0; i < delta->nobj; ++i)
+    {
+        if (delta->objindices[i] < 0 || delta->objindices[i] >= base->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
 
-CSIP_RETCODE CSIPsetStringParam(
-    CSIP_MODEL *model, const char *name, const char *value)
-{
-    SCIP_in_CSIP(SCIPsetStringParam(model->scip, name, value));
     return CSIP_RETCODE_OK;
 }
 
-int CSIPgetNumVars(CSIP_MODEL *model)
+struct scenario_batch
 {
-    return model->nvars;
-}
+    CSIP_MODEL *base;
+    CSIP_SCENARIO *deltas;
+    CSIP_SCENARIO_RESULT *results;
 
-int CSIPgetNumConss(CSIP_MODEL *model)
-{
-    return model->nconss;
-}
+    // one copy of base per worker, created on first use
+    CSIP_MODEL **models;
+    pthread_mutex_t lock;
+};
 
-CSIP_RETCODE CSIPsetInitialSolution(CSIP_MODEL *model, double *values)
+static
+CSIP_RETCODE solveScenario(void *data, int task, int worker)
 {
-    // are there missing values?
-    SCIP_Bool initialsolpartial = FALSE;
-    for(int i = 0; i < model->nvars; ++i)
+    struct scenario_batch *batch = (struct scenario_batch *) data;
+    CSIP_SCENARIO *delta = &batch->deltas[task];
+    CSIP_SCENARIO_RESULT *result = &batch->results[task];
+    CSIP_MODEL *model;
+
+    // copying reads (and captures) data of base, do one at a time
+    if (batch->models[worker] == NULL)
     {
-        SCIP_Real val = values[i];
-        if(val != val) // check for NaN
+        CSIP_RETCODE retcode;
+
+        pthread_mutex_lock(&batch->lock);
+        retcode = copyModel(batch->base, &batch->models[worker]);
+        pthread_mutex_unlock(&batch->lock);
+        CSIP_CALL(retcode);
+
+        // SCIP keeps solutions of previous solves as starting points, which
+        // makes results depend on which scenarios a worker solved before
+        if (batch->base->deterministic)
         {
-            initialsolpartial = TRUE;
-            break;
+            SCIP_in_CSIP(SCIPsetIntParam(batch->models[worker]->scip,
+                                         "limits/maxorigsol", 0));
         }
     }
+    model = batch->models[worker];
 
-    // was solution already given?
-    if (model->initialsol != NULL)
+    CSIP_CALL(applyScenario(model, batch->base, delta, FALSE));
+    CSIP_CALL(CSIPsolve(model));
+
+    result->status = CSIPgetStatus(model);
+    result->objbound = CSIPgetObjBound(model);
+    result->cpu = sched_getcpu();
+    result->objvalue = SCIPgetBestSol(model->scip) != NULL ?
+                       CSIPgetObjValue(model) : NAN;
+    if (result->values != NULL && SCIPgetBestSol(model->scip) != NULL)
     {
-        SCIP_in_CSIP(SCIPfreeSol(model->scip, &model->initialsol));
+        CSIP_CALL(CSIPgetVarValues(model, result->values));
     }
-    assert(model->initialsol == NULL);
 
-    // create new solution object
-    if(initialsolpartial)
+    CSIP_CALL(applyScenario(model, batch->base, delta, TRUE));
+
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE CSIPsolveScenarios(
+    CSIP_MODEL *base, int nscen, CSIP_SCENARIO *deltas, int nthreads,
+    CSIP_SCENARIO_RESULT *results)
+{
+    struct scenario_batch batch;
+    int t;
+
+    // callbacks can not be copied
+    if (base->nlazycb > 0 || base->nheur > 0)
     {
-        SCIP_in_CSIP(SCIPcreatePartialSol(model->scip, &model->initialsol, NULL));
+        return CSIP_RETCODE_ERROR;
+    }
 
-        // give only the proper values, skip NaN
-        for(int i = 0; i < model->nvars; ++i)
+    // workers exit on errors, so reject bad scenarios before any starts
+    for (t = 0; t < nscen; ++t)
+    {
+        CSIP_RETCODE retcode = checkScenario(base, &deltas[t]);
+
+        if (retcode != CSIP_RETCODE_OK)
         {
-            SCIP_Real val = values[i];
-            if(val == val) // check for NaN
-            {
-                SCIP_in_CSIP(SCIPsetSolVal(model->scip, model->initialsol,
-                                           model->vars[i], val));
-            }
+            return retcode;
         }
     }
-    else
+
+    if (base->deterministic)
     {
-        SCIP_in_CSIP(SCIPcreateSol(model->scip, &model->initialsol, NULL));
+        double timelimit;
 
-        // copy the given values
-        SCIP_in_CSIP(SCIPsetSolVals(model->scip, model->initialsol, model->nvars,
-                                    model->vars, values));
+        SCIP_in_CSIP(SCIPgetRealParam(base->scip, "limits/time", &timelimit));
+        if (!SCIPisInfinity(base->scip, timelimit))
+        {
+            SCIPwarningMessage(base->scip, "results of scenarios that hit the "
+                               "time limit depend on timing\n");
+        }
     }
 
-    // it will be given to SCIP in the CSIPsolve call
+    nthreads = MAX(1, MIN(nthreads, nscen));
+    batch.base = base;
+    batch.deltas = deltas;
+    batch.results = results;
+    batch.models = (CSIP_MODEL **) calloc(nthreads, sizeof(CSIP_MODEL *));
+    if (batch.models == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    pthread_mutex_init(&batch.lock, NULL);
 
-    return CSIP_RETCODE_OK;
-}
+    CSIP_CALL(parallelFor(nscen, nthreads, base, solveScenario, &batch));
 
-void *CSIPgetInternalSCIP(CSIP_MODEL *model)
-{
-    return model->scip;
-}
+    for (t = 0; t < nthreads; ++t)
+    {
+        if (batch.models[t] != NULL)
+        {
+            CSIP_CALL(CSIPfreeModel(batch.models[t]));
+        }
+    }
+    free(batch.models);
+    pthread_mutex_destroy(&batch.lock);
 
+    return CSIP_RETCODE_OK;
+}
 
 /*
- * Constraint Handler
+ * Benders decomposition
  */
 
-/* constraint handler data */
-struct SCIP_ConshdlrData
+struct benders_data
 {
-    CSIP_MODEL *model;
-    CSIP_LAZYCALLBACK callback;
-    void *userdata;
-    SCIP_Bool checkonly;
-    SCIP_Bool feasible;
-    SCIP_SOL *sol;
+    CSIP_MODEL *master;
+    int nsubs;
+    CSIP_MODEL **subs;
+    int nthreads;
+
+    // linking variables: masterindices[j] in master is linked to its copy
+    // in subproblem k by constraint linkconss[k * nlinks + j], copy - w = 0,
+    // where w = fixvars[k * nlinks + j] is fixed to the master value; the dual
+    // of that row is the derivative of the subproblem objective
+    int nlinks;
+    int *masterindices;
+    int *linkconss;
+    int *fixvars;
+    int *etaindices;
+
+    // no-good cuts are valid for binary linking variables only
+    SCIP_Bool allbinary;
+
+    // master solution and subproblem results of current callback
+    double *mastervals;
+    CSIP_STATUS *substatus;
+    double *subobj;
+    double *subduals;
 };
 
-SCIP_DECL_CONSFREE(consFreeLazy)
+static
+void freeBenders(struct benders_data *benders)
 {
-    SCIP_CONSHDLRDATA *conshdlrdata;
+    free(benders->subs);
+    free(benders->masterindices);
+    free(benders->linkconss);
+    free(benders->fixvars);
+    free(benders->etaindices);
+    free(benders->substatus);
+    free(benders->subobj);
+    free(benders->subduals);
+    free(benders);
+}
 
-    conshdlrdata = SCIPconshdlrGetData(conshdlr);
-    assert(conshdlrdata != NULL);
+static
+CSIP_RETCODE bendersSolveSub(void *data, int task, int worker)
+{
+    struct benders_data *benders = (struct benders_data *) data;
+    CSIP_MODEL *sub = benders->subs[task];
+    int nlinks = benders->nlinks;
+    int j;
 
-    SCIPfreeMemory(scip, &conshdlrdata);
+    for (j = 0; j < nlinks; ++j)
+    {
+        double val = benders->mastervals[benders->masterindices[j]];
+        CSIP_CALL(CSIPchgVarLB(sub, 1, &benders->fixvars[task * nlinks + j], &val));
+        CSIP_CALL(CSIPchgVarUB(sub, 1, &benders->fixvars[task * nlinks + j], &val));
+    }
 
-    SCIPconshdlrSetData(conshdlr, NULL);
+    CSIP_CALL(CSIPsolve(sub));
 
-    return SCIP_OKAY;
+    benders->substatus[task] = CSIPgetStatus(sub);
+    if (benders->substatus[task] != CSIP_STATUS_OPTIMAL)
+    {
+        return CSIP_RETCODE_OK;
+    }
+
+    benders->subobj[task] = CSIPgetObjValue(sub);
+    for (j = 0; j < nlinks; ++j)
+    {
+        SCIP_CONS *cons = sub->conss[benders->linkconss[task * nlinks + j]];
+        SCIP_Bool boundconstraint;
+
+        SCIP_in_CSIP(SCIPgetDualSolVal(sub->scip, cons,
+                                       &benders->subduals[task * nlinks + j], &boundconstraint));
+
+        // the dual of a bound constraint is a reduced cost, which is not
+        // available after the solve; link rows have two variables
+        if (boundconstraint)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    return CSIP_RETCODE_OK;
 }
 
-SCIP_DECL_CONSENFOLP(consEnfolpLazy)
+static
+CSIP_RETCODE bendersCallback(CSIP_MODEL *master, CSIP_LAZYDATA *lazydata,
+                             void *userdata)
 {
-    SCIP_CONSHDLRDATA *conshdlrdata;
+    struct benders_data *benders = (struct benders_data *) userdata;
+    CSIP_LAZY_CONTEXT context = CSIPlazyGetContext(lazydata);
+    int nlinks = benders->nlinks;
+    int *indices;
+    double *coefs;
+    int k;
+    int j;
+
+    benders->mastervals = (double *) malloc(master->nvars * sizeof(double));
+    indices = (int *) malloc((nlinks + 1) * sizeof(int));
+    coefs = (double *) malloc((nlinks + 1) * sizeof(double));
+    if (benders->mastervals == NULL || indices == NULL || coefs == NULL)
+    {
+        free(coefs);
+        free(indices);
+        free(benders->mastervals);
+        benders->mastervals = NULL;
+        return CSIP_RETCODE_NOMEMORY;
+    }
+
+    CSIP_CALL(CSIPlazyGetVarValues(lazydata, benders->mastervals));
+    CSIP_CALL(parallelFor(benders->nsubs, benders->nthreads, master,
+                          bendersSolveSub, benders));
+
+    for (k = 0; k < benders->nsubs; ++k)
+    {
+        double *duals = &benders->subduals[k * nlinks];
+        double eta = benders->mastervals[benders->etaindices[k]];
+
+        if (benders->substatus[k] == CSIP_STATUS_OPTIMAL)
+        {
+            // optimality cut: eta_k >= obj_k + sum_j duals_j (x_j - val_j)
+            double theta = benders->subobj[k];
+            double lhs = theta;
+
+            if (eta >= theta - SCIPfeastol(master->scip) * MAX(1.0, REALABS(theta)))
+            {
+                continue;
+            }
+            for (j = 0; j < nlinks; ++j)
+            {
+                indices[j] = benders->masterindices[j];
+                coefs[j] = -duals[j];
+                lhs -= duals[j] * benders->mastervals[indices[j]];
+            }
+            indices[nlinks] = benders->etaindices[k];
+            coefs[nlinks] = 1.0;
+            CSIP_CALL(CSIPlazyAddLinCons(lazydata, nlinks + 1, indices, coefs,
+                                         lhs, INFINITY, 0));
+        }
+        else if (benders->substatus[k] == CSIP_STATUS_INFEASIBLE)
+        {
+            // feasibility cut: without Farkas proofs we can only cut off
+            // integral assignments of binary linking variables (no-good)
+            double rhs = -1.0;
+
+            if (context != CSIP_LAZY_INTEGRALSOL)
+            {
+                continue;
+            }
+            if (!benders->allbinary)
+            {
+                free(coefs);
+                free(indices);
+                free(benders->mastervals);
+                benders->mastervals = NULL;
+                return CSIP_RETCODE_ERROR;
+            }
+            for (j = 0; j < nlinks; ++j)
+            {
+                indices[j] = benders->masterindices[j];
+                if (benders->mastervals[indices[j]] > 0.5)
+                {
+                    coefs[j] = 1.0;
+                    rhs += 1.0;
+                }
+                else
+                {
+                    coefs[j] = -1.0;
+                }
+            }
+            CSIP_CALL(CSIPlazyAddLinCons(lazydata, nlinks, indices, coefs,
+                                         -INFINITY, rhs, 0));
+        }
+        else
+        {
+            free(coefs);
+            free(indices);
+            free(benders->mastervals);
+            benders->mastervals = NULL;
+            return CSIP_RETCODE_ERROR;
+        }
+    }
 
-    *result = SCIP_FEASIBLE;
+    free(coefs);
+    free(indices);
+    free(benders->mastervals);
+    benders->mastervals = NULL;
 
-    conshdlrdata = SCIPconshdlrGetData(conshdlr);
-    conshdlrdata->checkonly = FALSE;
-    conshdlrdata->feasible = TRUE;
+    return CSIP_RETCODE_OK;
+}
 
-    CSIP_in_SCIP(conshdlrdata->callback(conshdlrdata->model,
-                                        conshdlrdata, conshdlrdata->userdata));
+// check all arguments of CSIPbenders before anything is changed
+static
+CSIP_RETCODE checkBenders(CSIP_MODEL *master, int nsubs, CSIP_MODEL **subs,
+                          int nlinks, int *masterindices, int *subindices)
+{
+    int k;
+    int j;
+    int v;
 
-    if (!conshdlrdata->feasible)
+    if (master->benders != NULL || nsubs < 1 || nlinks < 0
+            || SCIPgetObjsense(master->scip) != SCIP_OBJSENSE_MINIMIZE)
     {
-        *result = SCIP_CONSADDED;
+        return CSIP_RETCODE_ERROR;
+    }
+    for (j = 0; j < nlinks; ++j)
+    {
+        if (masterindices[j] < 0 || masterindices[j] >= master->nvars)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
     }
 
-    return SCIP_OKAY;
-}
+    for (k = 0; k < nsubs; ++k)
+    {
+        CSIP_MODEL *sub = subs[k];
 
-/* enfo pseudo solution just call enfo lp solution */
-SCIP_DECL_CONSENFOPS(consEnfopsLazy)
-{
-    return consEnfolpLazy(scip, conshdlr, conss, nconss, nusefulconss,
-                          solinfeasible, result);
+        // duals are only meaningful for LPs that are not presolved
+        if (sub == master
+                || SCIPgetObjsense(sub->scip) != SCIP_OBJSENSE_MINIMIZE
+                || sub->nlazycb > 0 || sub->nheur > 0)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        for (v = 0; v < sub->nvars; ++v)
+        {
+            if (CSIPgetVarType(sub, v) != CSIP_VARTYPE_CONTINUOUS)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+        }
+        for (j = 0; j < nlinks; ++j)
+        {
+            if (subindices[k * nlinks + j] < 0
+                    || subindices[k * nlinks + j] >= sub->nvars)
+            {
+                return CSIP_RETCODE_ERROR;
+            }
+        }
+    }
+
+    return CSIP_RETCODE_OK;
 }
 
-/* check callback */
-SCIP_DECL_CONSCHECK(consCheckLazy)
+// add the link variables and rows to the subproblems, and eta to master
+static
+CSIP_RETCODE addBendersLinks(struct benders_data *benders, int *subindices,
+                             double *sublowerbounds)
 {
-    SCIP_CONSHDLRDATA *conshdlrdata;
+    CSIP_MODEL *master = benders->master;
+    int nlinks = benders->nlinks;
+    double one = 1.0;
+    double linkcoefs[2] = {1.0, -1.0};
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
+    int k;
+    int j;
+
+    for (k = 0; k < benders->nsubs && retcode == CSIP_RETCODE_OK; ++k)
+    {
+        CSIP_MODEL *sub = benders->subs[k];
 
-    *result = SCIP_FEASIBLE;
+        retcode = CSIPsetIntParam(sub, "presolving/maxrounds", 0);
+        if (retcode == CSIP_RETCODE_OK)
+        {
+            retcode = CSIPsetIntParam(sub, "propagating/maxroundsroot", 0);
+        }
 
-    conshdlrdata = SCIPconshdlrGetData(conshdlr);
-    conshdlrdata->checkonly = TRUE;
-    conshdlrdata->feasible = TRUE;
-    conshdlrdata->sol = sol;
+        // link copies of linking variables to a variable that is fixed in
+        // each callback; a row on the copy alone would be a bound constraint,
+        // whose dual SCIP does not keep
+        for (j = 0; j < nlinks && retcode == CSIP_RETCODE_OK; ++j)
+        {
+            int linkindices[2];
 
-    CSIP_in_SCIP(conshdlrdata->callback(conshdlrdata->model,
-                                        conshdlrdata, conshdlrdata->userdata));
+            linkindices[0] = subindices[k * nlinks + j];
+            retcode = CSIPaddVar(sub, -INFINITY, INFINITY,
+                                 CSIP_VARTYPE_CONTINUOUS, &linkindices[1]);
+            if (retcode == CSIP_RETCODE_OK)
+            {
+                benders->fixvars[k * nlinks + j] = linkindices[1];
+                retcode = CSIPaddLinCons(sub, 2, linkindices, linkcoefs, 0.0,
+                                         0.0, &benders->linkconss[k * nlinks + j]);
+            }
+        }
 
-    if (!conshdlrdata->feasible)
-    {
-        *result = SCIP_INFEASIBLE;
+        // eta_k estimates the objective value of subproblem k
+        if (retcode == CSIP_RETCODE_OK)
+        {
+            retcode = CSIPaddVar(master, sublowerbounds[k], INFINITY,
+                                 CSIP_VARTYPE_CONTINUOUS, &benders->etaindices[k]);
+        }
+        if (retcode == CSIP_RETCODE_OK)
+        {
+            retcode = setVarObj(master, benders->etaindices[k], 1.0);
+        }
+        if (retcode == CSIP_RETCODE_OK && master->recording != NULL)
+        {
+            recordOp(master, RECORD_SETOBJ);
+            recordInts(master, 1, &benders->etaindices[k]);
+            recordDoubles(master, 1, &one);
+            recordEnd(master);
+        }
     }
 
-    return SCIP_OKAY;
+    return retcode;
 }
 
-/* locks callback */
-SCIP_DECL_CONSLOCK(consLockLazy)
+CSIP_RETCODE CSIPbenders(
+    CSIP_MODEL *master, int nsubs, CSIP_MODEL **subs, int nlinks,
+    int *masterindices, int *subindices, double *sublowerbounds, int nthreads,
+    int *etaindices)
 {
-    int i;
-    SCIP_VAR *var;
-    SCIP_CONSHDLRDATA *conshdlrdata;
+    struct benders_data *benders;
+    CSIP_RETCODE retcode;
+    int j;
 
-    conshdlrdata = SCIPconshdlrGetData(conshdlr);
+    retcode = checkBenders(master, nsubs, subs, nlinks, masterindices,
+                           subindices);
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        return retcode;
+    }
 
-    assert(scip == conshdlrdata->model->scip);
+    benders = (struct benders_data *) calloc(1, sizeof(struct benders_data));
+    if (benders == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    benders->master = master;
+    benders->nsubs = nsubs;
+    benders->nlinks = nlinks;
+    benders->nthreads = MAX(1, MIN(nthreads, nsubs));
+    benders->subs = (CSIP_MODEL **) malloc(nsubs * sizeof(CSIP_MODEL *));
+    benders->masterindices = (int *) malloc(MAX(1, nlinks) * sizeof(int));
+    benders->linkconss = (int *) malloc(MAX(1, nsubs * nlinks) * sizeof(int));
+    benders->fixvars = (int *) malloc(MAX(1, nsubs * nlinks) * sizeof(int));
+    benders->etaindices = (int *) malloc(nsubs * sizeof(int));
+    benders->substatus = (CSIP_STATUS *) malloc(nsubs * sizeof(CSIP_STATUS));
+    benders->subobj = (double *) malloc(nsubs * sizeof(double));
+    benders->subduals = (double *) malloc(MAX(1, nsubs * nlinks) * sizeof(
+                                              double));
+    if (benders->subs == NULL || benders->masterindices == NULL
+            || benders->linkconss == NULL || benders->fixvars == NULL
+            || benders->etaindices == NULL
+            || benders->substatus == NULL || benders->subobj == NULL
+            || benders->subduals == NULL)
+    {
+        freeBenders(benders);
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    memcpy(benders->subs, subs, nsubs * sizeof(CSIP_MODEL *));
+    memcpy(benders->masterindices, masterindices, nlinks * sizeof(int));
 
-    for (i = 0; i < conshdlrdata->model->nvars; ++i)
+    benders->allbinary = TRUE;
+    for (j = 0; j < nlinks; ++j)
     {
-        var = conshdlrdata->model->vars[i];
-        SCIP_CALL(SCIPaddVarLocks(scip, var, nlockspos + nlocksneg,
-                                  nlockspos + nlocksneg));
+        benders->allbinary = benders->allbinary
+                             && (CSIPgetVarType(master, masterindices[j])
+                                 == CSIP_VARTYPE_BINARY);
     }
 
-    return SCIP_OKAY;
+    // the decomposition is only attached to master once it is complete
+    retcode = addBendersLinks(benders, subindices, sublowerbounds);
+    if (retcode == CSIP_RETCODE_OK)
+    {
+        retcode = CSIPaddLazyCallback(master, bendersCallback, benders);
+    }
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        freeBenders(benders);
+        return retcode;
+    }
+    master->benders = benders;
+
+    // no-good cuts are the only feasibility cuts we have
+    if (!benders->allbinary)
+    {
+        SCIPwarningMessage(master->scip, "CSIPbenders: linking variables "
+                           "are not all binary, subproblems need complete "
+                           "recourse\n");
+    }
+
+    if (etaindices != NULL)
+    {
+        memcpy(etaindices, benders->etaindices, nsubs * sizeof(int));
+    }
+
+    return CSIP_RETCODE_OK;
 }
 
 /*
- * callback methods
+ *  Message handler with a prefix
  */
 
-CSIP_RETCODE CSIPaddLazyCallback(CSIP_MODEL *model, CSIP_LAZYCALLBACK callback,
-                                 void *userdata)
+
+struct SCIP_MessagehdlrData
 {
-    SCIP_CONSHDLRDATA *conshdlrdata;
-    SCIP_CONSHDLR *conshdlr;
-    SCIP *scip;
-    char name[SCIP_MAXSTRLEN];
-    int enfopriority;
-    int checkpriority;
-    int eagerfreq;
-    SCIP_Bool needscons = FALSE;
+    char* prefix;
+};
 
-    scip = model->scip;
+static void logMessage(
+    SCIP_MESSAGEHDLR* messagehdlr, FILE* file, const char* msg)
+{
+    SCIP_MESSAGEHDLRDATA* messagehdlrdata;
+    messagehdlrdata = SCIPmessagehdlrGetData(messagehdlr);
 
-    /* cons_integral has enfo priority 0 and we want to be checked before */
-    enfopriority = 1;
-    /* we want to be checked as rarely as possible.
-     * -5000000 is the smallest proper value in SCIP's conshdlrs. */
-    checkpriority = -5000000 - 1;
-    /* no eager evaluations?! */
-    eagerfreq = -1;
+    fputs(messagehdlrdata->prefix, file);
+    fputs(msg, file);
+    fflush(file);
+    return;
+}
 
-    SCIP_in_CSIP(SCIPallocMemory(scip, &conshdlrdata));
+static SCIP_DECL_MESSAGEHDLRFREE(messageHdlrFree)
+{
+    SCIP_MESSAGEHDLRDATA* messagehdlrdata = SCIPmessagehdlrGetData(messagehdlr);
+    free(messagehdlrdata->prefix);
+    SCIPfreeMemory(NULL, &messagehdlrdata);
+    return SCIP_OKAY;
+}
 
-    conshdlrdata->model = model;
-    conshdlrdata->callback = callback;
-    conshdlrdata->userdata = userdata;
+// the handler is owned by SCIP, model->msghdlr only identifies it
+static
+CSIP_RETCODE setPrefixMessagehdlr(CSIP_MODEL *model, const char* prefix)
+{
+    SCIP_MESSAGEHDLR* messagehdlr = NULL;
+    SCIP_MESSAGEHDLRDATA* messagehdlrdata = NULL;
 
-    SCIPsnprintf(name, SCIP_MAXSTRLEN, "lazycons_%d", model->nlazycb);
-    SCIP_in_CSIP(SCIPincludeConshdlrBasic(
-                     scip, &conshdlr, name, "lazy constraint callback",
-                     enfopriority, checkpriority, eagerfreq, needscons,
-                     consEnfolpLazy, consEnfopsLazy, consCheckLazy, consLockLazy,
-                     conshdlrdata));
+    SCIP_in_CSIP(SCIPallocMemory(NULL, &messagehdlrdata));
+    messagehdlrdata->prefix = strDup(prefix);
+    SCIP_in_CSIP(SCIPmessagehdlrCreate(&messagehdlr, FALSE, NULL, FALSE,
+                                       logMessage, logMessage, logMessage,
+                                       messageHdlrFree, messagehdlrdata));
 
-    SCIP_in_CSIP(SCIPsetConshdlrFree(scip, conshdlr, consFreeLazy));
-    model->nlazycb += 1;
+    SCIP_in_CSIP(SCIPsetMessagehdlr(model->scip, messagehdlr));
+    model->msghdlr = messagehdlr;
+    SCIP_in_CSIP(SCIPmessagehdlrRelease(&messagehdlr));
 
     return CSIP_RETCODE_OK;
 }
 
+// prefix of the message handler of model, or NULL if it has none
 static
-CSIP_RETCODE isSolIntegral(SCIP *scip, SCIP_SOL *sol, SCIP_Bool *integral)
+const char *getMessagePrefix(CSIP_MODEL *model)
 {
-    // inspired by consCheckIntegral in cons_integral.c
-    SCIP_VAR **vars;
-    SCIP_Real solval;
-    int nbin, nint, nimpl, nallinteger;
+    if (model->msghdlr == NULL
+            || SCIPgetMessagehdlr(model->scip) != model->msghdlr)
+    {
+        return NULL;
+    }
 
-    SCIP_in_CSIP(SCIPgetSolVarsData(scip, sol, &vars, NULL,
-                                    &nbin, &nint, &nimpl, NULL));
+    return SCIPmessagehdlrGetData(model->msghdlr)->prefix;
+}
 
-    *integral = TRUE;
-    nallinteger = nbin + nint + nimpl;
-    for (int v = 0; v < nallinteger; ++v)
+CSIP_RETCODE CSIPsetMessagePrefix(CSIP_MODEL *model, const char* prefix)
+{
+    if (model->recording != NULL)
     {
-        solval = SCIPgetSolVal(scip, sol, vars[v]);
-        if (!SCIPisFeasIntegral(scip, solval))
-        {
-            *integral = FALSE;
-            break;
-        }
+        recordOp(model, RECORD_SETMESSAGEPREFIX);
+        recordString(model, prefix);
+        recordEnd(model);
     }
 
+    CSIP_CALL(setPrefixMessagehdlr(model, prefix));
+
     return CSIP_RETCODE_OK;
 }
 
+/*
+ * API call recording and replay
+ */
 
-CSIP_LAZY_CONTEXT CSIPlazyGetContext(CSIP_LAZYDATA *lazydata)
+CSIP_RETCODE CSIPstartRecording(CSIP_MODEL *model, const char *path)
 {
-    SCIP_Bool check = lazydata->checkonly;
-    SCIP_SOL *sol = check ? lazydata->sol : NULL;
-    SCIP_Bool integral = FALSE;
-    CSIP_CALL(isSolIntegral(lazydata->model->scip, sol, &integral));
+    int header[2] = {RECORD_MAGIC, RECORD_VERSION};
 
-    if (integral)
-    {
-        return CSIP_LAZY_INTEGRALSOL;
-    }
-    else if (!check)
+    if (model->recording != NULL)
     {
-        return CSIP_LAZY_LPRELAX;
+        fclose(model->recording);
     }
-    else
+
+    model->recording = fopen(path, "wb");
+    if (model->recording == NULL)
     {
-        return CSIP_LAZY_OTHER;
+        return CSIP_RETCODE_ERROR;
     }
+    fwrite(header, sizeof(int), 2, model->recording);
+
+    return CSIP_RETCODE_OK;
 }
 
-/* returns LP or given solution depending whether we are called from check or enfo */
-CSIP_RETCODE CSIPlazyGetVarValues(CSIP_LAZYDATA *lazydata, double *output)
+CSIP_RETCODE CSIPstopRecording(CSIP_MODEL *model)
 {
-    int i;
-    SCIP *scip;
-    SCIP_VAR *var;
-    SCIP_SOL *sol;
-
-    scip = lazydata->model->scip;
-    sol = lazydata->checkonly ? lazydata->sol : NULL;
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
 
-    for (i = 0; i < lazydata->model->nvars; ++i)
+    if (model->recording != NULL)
     {
-        var = lazydata->model->vars[i];
-        output[i] = SCIPgetSolVal(scip, sol, var);
+        if (ferror(model->recording) || fclose(model->recording) != 0)
+        {
+            retcode = CSIP_RETCODE_ERROR;
+        }
+        model->recording = NULL;
     }
 
-    return CSIP_RETCODE_OK;
+    return retcode;
 }
 
-CSIP_RETCODE CSIPlazyAddLinCons(CSIP_LAZYDATA *lazydata, int numindices,
-                                int *indices,
-                                double *coefs, double lhs, double rhs, int islocal)
+#define RECORD_MAXFIELDS 16
+
+struct record_field
 {
-    SCIP *scip;
-    SCIP_CONS *cons;
-    SCIP_SOL *sol;
-    SCIP_RESULT result;
+    char tag;
+    int n;
+    void *data;
+};
 
-    scip = lazydata->model->scip;
+struct record_entry
+{
+    int op;
+    int nfields;
+    struct record_field fields[RECORD_MAXFIELDS];
+};
 
-    if (lazydata->checkonly)
-    {
-        sol = lazydata->sol;
-    }
-    else
-    {
-        sol = NULL;
-    }
+struct replay_data
+{
+    int nentries;
+    int entriessize;
+    struct record_entry *entries;
+
+    // events of the current solve, fed back by the replay callbacks
+    int first;
+    int last;
+    SCIP_Bool sols_added;
+};
 
-    /* Is it reasonable to assume that if we solved the problem, then the lazy constraint
-     * is satisfied in the original problem? We get the error:
-     * "method <SCIPcreateCons> cannot be called in the solved stage"
-     * and I am guessing this is because SCIP is checking whether the solution found in the
-     * presolved problem is feasible for the original problem. It could happen it is not feasible
-     * because of numerics mainly, hence the question in the comment
-     */
-    if (SCIPgetStage(scip) == SCIP_STAGE_SOLVED)
+static
+void freeReplay(struct replay_data *replay)
+{
+    for (int i = 0; i < replay->nentries; ++i)
     {
-        assert(lazydata->checkonly);
-        lazydata->feasible = TRUE; /* to be very explicit */
-        return CSIP_RETCODE_OK;
+        for (int f = 0; f < replay->entries[i].nfields; ++f)
+        {
+            free(replay->entries[i].fields[f].data);
+        }
     }
+    free(replay->entries);
+    free(replay);
+}
 
-    if (SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMED)
+static
+void freeRecordEntry(struct record_entry *entry)
+{
+    for (int f = 0; f < entry->nfields; ++f)
     {
-        // we can't even create a cons in this stage, we trust the user's judgement
-        lazydata->feasible = FALSE;
-        return CSIP_RETCODE_OK;
+        free(entry->fields[f].data);
     }
+    entry->nfields = 0;
+}
 
-    CSIP_CALL(createLinCons(lazydata->model, numindices, indices, coefs, lhs, rhs,
-                            &cons));
-    SCIP_in_CSIP(SCIPsetConsLocal(scip, cons, islocal == 1));
-    SCIP_in_CSIP(SCIPcheckCons(scip, cons, sol, FALSE, FALSE, FALSE, &result));
+// whether the fields of entry match the layout of its opcode, so that
+// replayEntry can access them
+static
+SCIP_Bool checkRecordEntry(struct record_entry *entry)
+{
+    const char *layout;
 
-    if (result == SCIP_INFEASIBLE)
+    if (entry->op < 1 || entry->op > RECORD_MAXOP)
     {
-        lazydata->feasible = FALSE;
+        return FALSE;
     }
-
-    /* can not add constraints here */
-    if (SCIPgetStage(scip) == SCIP_STAGE_INIT
-            || SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMING
-            || SCIPgetStage(scip) == SCIP_STAGE_INITSOLVE)
+    layout = recordlayouts[entry->op];
+    if ((int) strlen(layout) != entry->nfields)
     {
-        assert(lazydata->checkonly);
-        SCIP_in_CSIP(SCIPreleaseCons(lazydata->model->scip, &cons));
-        return CSIP_RETCODE_OK;
+        return FALSE;
     }
 
-    /* we do not store cons, because the original problem does not contain them;
-     * and there is an issue when freeTransform is called
-     */
-    SCIP_in_CSIP(SCIPaddCons(scip, cons));
-    SCIP_in_CSIP(SCIPreleaseCons(lazydata->model->scip, &cons));
-
-    return CSIP_RETCODE_OK;
-}
+    for (int f = 0; f < entry->nfields; ++f)
+    {
+        struct record_field *field = &entry->fields[f];
+        SCIP_Bool isarray = isupper((unsigned char) layout[f]);
+        char tag = tolower((unsigned char) layout[f]);
 
-/* Heuristic Plugin */
+        if (field->tag == RECORD_NULL && isarray)
+        {
+            continue;
+        }
+        if (field->tag != tag)
+        {
+            return FALSE;
+        }
+        if (tag == RECORD_CHARS)
+        {
+            if (field->n < 1 || ((char *) field->data)[field->n - 1] != '\0')
+            {
+                return FALSE;
+            }
+        }
+        else if (!isarray && field->n != 1)
+        {
+            return FALSE;
+        }
+    }
 
-struct SCIP_HeurData
-{
-    CSIP_MODEL *model;
-    CSIP_HEURCALLBACK callback;
-    void *userdata;
-    SCIP_HEUR *heur;
-    unsigned int stored_sols;
-};
+    return TRUE;
+}
 
 static
-SCIP_DECL_HEURFREE(heurFreeUser)
+CSIP_RETCODE readRecordFields(FILE *file, struct record_entry *entry)
 {
-    SCIP_HEURDATA *heurdata;
+    int tag;
 
-    heurdata = SCIPheurGetData(heur);
-    assert(heurdata != NULL);
+    while ((tag = fgetc(file)) != RECORD_END)
+    {
+        struct record_field *field = &entry->fields[entry->nfields];
+        size_t size;
 
-    SCIPfreeMemory(scip, &heurdata);
-    SCIPheurSetData(heur, NULL);
+        if (tag == EOF || entry->nfields >= RECORD_MAXFIELDS
+                || fread(&field->n, sizeof(int), 1, file) != 1 || field->n < 0)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        field->tag = tag;
+        field->data = NULL;
+        ++(entry->nfields);
 
-    return SCIP_OKAY;
+        switch (tag)
+        {
+        case RECORD_NULL:
+            continue;
+        case RECORD_INTS:
+            size = sizeof(int);
+            break;
+        case RECORD_LONGS:
+            size = sizeof(long long);
+            break;
+        case RECORD_DOUBLES:
+            size = sizeof(double);
+            break;
+        case RECORD_CHARS:
+            size = sizeof(char);
+            break;
+        default:
+            return CSIP_RETCODE_ERROR;
+        }
+
+        // keep a valid pointer for empty arrays, as the API expects
+        field->data = malloc(MAX(1, field->n) * size);
+        if (field->data == NULL)
+        {
+            return CSIP_RETCODE_NOMEMORY;
+        }
+        if (field->n > 0 && fread(field->data, size, field->n, file)
+                != (size_t) field->n)
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+    }
+
+    return checkRecordEntry(entry) ? CSIP_RETCODE_OK : CSIP_RETCODE_ERROR;
 }
 
+// reads one entry; on errors, nothing is left allocated
 static
-SCIP_DECL_HEUREXEC(heurExecUser)
+CSIP_RETCODE readRecordEntry(FILE *file, struct record_entry *entry,
+                             SCIP_Bool *eof)
 {
-    SCIP_HEURDATA *heurdata = SCIPheurGetData(heur);
-    assert(heurdata != NULL);
-
-    *result = SCIP_DIDNOTFIND;
-    heurdata->stored_sols = 0;
+    CSIP_RETCODE retcode;
 
-    CSIP_in_SCIP(heurdata->callback(heurdata->model, heurdata,
-                                    heurdata->userdata));
+    *eof = fread(&entry->op, sizeof(int), 1, file) != 1;
+    entry->nfields = 0;
+    if (*eof)
+    {
+        return CSIP_RETCODE_OK;
+    }
 
-    if (heurdata->stored_sols > 0)
+    retcode = readRecordFields(file, entry);
+    if (retcode != CSIP_RETCODE_OK)
     {
-        *result = SCIP_FOUNDSOL;
+        freeRecordEntry(entry);
     }
 
-    return SCIP_OKAY;
+    return retcode;
 }
 
-// Copy values of solution to output array. Call this function from your
-// heuristic callback. Solution is LP relaxation of current node.
-CSIP_RETCODE CSIPheurGetVarValues(CSIP_HEURDATA *heurdata, double *output)
+// re-add recorded lazy constraints that are violated by the current solution
+static
+CSIP_RETCODE replayLazyCallback(CSIP_MODEL *model, CSIP_LAZYDATA *lazydata,
+                                void *userdata)
 {
-    CSIP_MODEL *model = heurdata->model;
-    SCIP_in_CSIP(SCIPgetSolVals(model->scip, NULL, model->nvars, model->vars,
-                                output));
+    struct replay_data *replay = (struct replay_data *) userdata;
+    double *values = (double *) malloc(model->nvars * sizeof(double));
+
+    if (values == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    CSIP_CALL(CSIPlazyGetVarValues(lazydata, values));
+
+    for (int i = replay->first; i < replay->last; ++i)
+    {
+        struct record_field *f = replay->entries[i].fields;
+        int *indices;
+        double *coefs;
+        double lhs;
+        double rhs;
+        double activity = 0.0;
+
+        if (replay->entries[i].op != RECORD_LAZYCONS)
+        {
+            continue;
+        }
+        indices = (int *) f[0].data;
+        coefs = (double *) f[1].data;
+        lhs = *(double *) f[2].data;
+        rhs = *(double *) f[3].data;
+        for (int k = 0; k < f[0].n; ++k)
+        {
+            activity += coefs[k] * values[indices[k]];
+        }
+        if (activity < lhs - SCIPfeastol(model->scip)
+                || activity > rhs + SCIPfeastol(model->scip))
+        {
+            CSIP_CALL(CSIPlazyAddLinCons(lazydata, f[0].n, indices, coefs, lhs,
+                                         rhs, *(int *) f[4].data));
+        }
+    }
+
+    free(values);
+
     return CSIP_RETCODE_OK;
 }
 
-// Supply a solution (as a dense array). Only complete solutions are supported.
-CSIP_RETCODE CSIPheurAddSolution(CSIP_HEURDATA *heurdata, double *values)
+// offer all recorded heuristic solutions of the current solve, once
+static
+CSIP_RETCODE replayHeurCallback(CSIP_MODEL *model, CSIP_HEURDATA *heurdata,
+                                void *userdata)
 {
-    SCIP_SOL *sol;
-    CSIP_MODEL *model = heurdata->model;
-    SCIP *scip = model->scip;
-    unsigned int stored = 0;
-
-    SCIP_in_CSIP(SCIPcreateSol(scip, &sol, heurdata->heur));
-    SCIP_in_CSIP(SCIPsetSolVals(scip, sol, model->nvars, model->vars, values));
-    SCIP_in_CSIP(SCIPtrySolFree(scip, &sol, FALSE, FALSE, TRUE, TRUE, TRUE, &stored));
+    struct replay_data *replay = (struct replay_data *) userdata;
 
-    if (stored > 0)
+    if (replay->sols_added)
     {
-        heurdata->stored_sols += 1;
+        return CSIP_RETCODE_OK;
+    }
+    for (int i = replay->first; i < replay->last; ++i)
+    {
+        struct record_entry *entry = &replay->entries[i];
+
+        if (entry->op == RECORD_HEURSOL && entry->fields[0].n == model->nvars)
+        {
+            CSIP_CALL(CSIPheurAddSolution(heurdata,
+                                          (double *) entry->fields[0].data));
+        }
     }
+    replay->sols_added = TRUE;
 
     return CSIP_RETCODE_OK;
 }
 
-// Add a heuristic callback to the model.
-// You may use userdata to pass any data.
-CSIP_RETCODE CSIPaddHeuristicCallback(
-    CSIP_MODEL *model, CSIP_HEURCALLBACK callback, void *userdata)
+static
+CSIP_RETCODE replayEntry(CSIP_MODEL *model, struct replay_data *replay,
+                         int i, SCIP_Bool *lazyadded, SCIP_Bool *heuradded)
 {
-    SCIP_HEURDATA *heurdata;
-    SCIP_HEUR *heur;
-    SCIP *scip;
-    char name[SCIP_MAXSTRLEN];
-
-    scip = model->scip;
+    struct record_entry *entry = &replay->entries[i];
+    struct record_field *f = entry->fields;
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
 
-    SCIP_in_CSIP(SCIPallocMemory(scip, &heurdata));
+// field k of the entry, as scalar or array of the given type
+#define FIELD(k, type) (*(type *) f[k].data)
+#define ARRAY(k, type) ((type *) f[k].data)
 
-    SCIPsnprintf(name, SCIP_MAXSTRLEN, "heur_%d", model->nheur);
-    SCIP_in_CSIP(SCIPincludeHeurBasic(
-                     scip, &heur, name, "heuristic callback", 'x',
-                     1, 1, 0, -1, SCIP_HEURTIMING_AFTERNODE, FALSE,
-                     heurExecUser, heurdata));
-    heurdata->model = model;
-    heurdata->callback = callback;
-    heurdata->userdata = userdata;
-    heurdata->heur = heur;
-    heurdata->stored_sols = 0;
+    switch (entry->op)
+    {
+    case RECORD_ADDVAR:
+        retcode = CSIPaddVar(model, FIELD(0, double), FIELD(1, double),
+                             FIELD(2, int), NULL);
+        break;
+    case RECORD_CHGVARLB:
+        retcode = CSIPchgVarLB(model, f[0].n, ARRAY(0, int), ARRAY(1, double));
+        break;
+    case RECORD_CHGVARUB:
+        retcode = CSIPchgVarUB(model, f[0].n, ARRAY(0, int), ARRAY(1, double));
+        break;
+    case RECORD_CHGVARTYPE:
+        retcode = CSIPchgVarType(model, FIELD(0, int), FIELD(1, int));
+        break;
+    case RECORD_ADDLINCONS:
+        retcode = CSIPaddLinCons(model, f[0].n, ARRAY(0, int), ARRAY(1, double),
+                                 FIELD(2, double), FIELD(3, double), NULL);
+        break;
+    case RECORD_ADDQUADCONS:
+        retcode = CSIPaddQuadCons(model, f[0].n, ARRAY(0, int), ARRAY(1, double),
+                                  f[2].n, ARRAY(2, int), ARRAY(3, int), ARRAY(4, double),
+                                  FIELD(5, double), FIELD(6, double), NULL);
+        break;
+    case RECORD_ADDNONLINCONS:
+        retcode = CSIPaddNonLinCons(model, f[0].n, ARRAY(0, CSIP_OP),
+                                    ARRAY(1, int), ARRAY(2, int), ARRAY(3, double),
+                                    FIELD(4, double), FIELD(5, double), NULL);
+        break;
+    case RECORD_ADDNONLINCONSS:
+        retcode = CSIPaddNonLinConss(model, f[4].n - 1, ARRAY(4, int),
+                                     ARRAY(0, CSIP_OP), ARRAY(1, int), ARRAY(2, int),
+                                     ARRAY(3, double), ARRAY(5, double), ARRAY(6, double),
+                                     NULL);
+        break;
+    case RECORD_REGISTEREXPRTEMPLATE:
+        retcode = CSIPregisterExprTemplate(model, f[0].n, ARRAY(0, CSIP_OP),
+                                           ARRAY(1, int), ARRAY(2, int), ARRAY(3, double),
+                                           FIELD(4, int), NULL);
+        break;
+    case RECORD_ADDNONLINCONSFROMTEMPLATE:
+        retcode = CSIPaddNonLinConsFromTemplate(model, FIELD(0, int),
+                                                FIELD(1, int), ARRAY(2, int), ARRAY(3, double),
+                                                ARRAY(4, double), ARRAY(5, double), NULL);
+        break;
+    case RECORD_SETNONLINCONSCURVATURE:
+        retcode = CSIPsetNonLinConsCurvature(model, FIELD(0, int),
+                                             FIELD(1, int));
+        break;
+    case RECORD_SETNONLINEAROBJCURVATURE:
+        retcode = CSIPsetNonlinearObjCurvature(model, FIELD(0, int));
+        break;
+    case RECORD_ADDORBITOPE:
+        if (f[2].n != FIELD(0, int) * FIELD(1, int))
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        retcode = CSIPaddOrbitope(model, FIELD(0, int), FIELD(1, int),
+                                  ARRAY(2, int), FIELD(3, int), NULL);
+        break;
+    case RECORD_ADDSYMMETRICBLOCKS:
+        if (f[2].n != FIELD(0, int) * FIELD(1, int))
+        {
+            return CSIP_RETCODE_ERROR;
+        }
+        retcode = CSIPaddSymmetricBlocks(model, FIELD(0, int), FIELD(1, int),
+                                         ARRAY(2, int), NULL);
+        break;
+    case RECORD_ADDBOUNDDISJUNCTION:
+        retcode = CSIPaddBoundDisjunction(model, f[0].n, ARRAY(0, int),
+                                          ARRAY(1, int), ARRAY(2, double), NULL);
+        break;
+    case RECORD_ADDCUMULATIVE:
+        retcode = CSIPaddCumulative(model, f[0].n, ARRAY(0, int), ARRAY(1, int),
+                                    ARRAY(2, int), FIELD(3, int), NULL);
+        break;
+    case RECORD_SETCALLBACKBUDGET:
+        retcode = CSIPsetCallbackBudget(model, FIELD(0, int), FIELD(1, int),
+                                        FIELD(2, double), FIELD(3, int));
+        break;
+    case RECORD_ADDSOS1:
+        retcode = CSIPaddSOS1(model, f[0].n, ARRAY(0, int), ARRAY(1, double),
+                              NULL);
+        break;
+    case RECORD_ADDSOS2:
+        retcode = CSIPaddSOS2(model, f[0].n, ARRAY(0, int), ARRAY(1, double),
+                              NULL);
+        break;
+    case RECORD_ADDSOSBATCH:
+        retcode = CSIPaddSOSBatch(model, FIELD(0, int), f[1].n - 1, ARRAY(1, int),
+                                  ARRAY(2, int), ARRAY(3, double), NULL);
+        break;
+    case RECORD_SETOBJ:
+        retcode = CSIPsetObj(model, f[0].n, ARRAY(0, int), ARRAY(1, double));
+        break;
+    case RECORD_REPLACEOBJ:
+        retcode = CSIPreplaceObj(model, f[0].n, ARRAY(0, int), ARRAY(1, double));
+        break;
+    case RECORD_SETNONLINEAROBJ:
+        retcode = CSIPsetNonlinearObj(model, f[0].n, ARRAY(0, CSIP_OP),
+                                      ARRAY(1, int), ARRAY(2, int), ARRAY(3, double));
+        break;
+    case RECORD_SETSENSEMIN:
+        retcode = CSIPsetSenseMinimize(model);
+        break;
+    case RECORD_SETSENSEMAX:
+        retcode = CSIPsetSenseMaximize(model);
+        break;
+    case RECORD_SETBOOLPARAM:
+        retcode = CSIPsetBoolParam(model, ARRAY(0, char), FIELD(1, int));
+        break;
+    case RECORD_SETINTPARAM:
+        retcode = CSIPsetIntParam(model, ARRAY(0, char), FIELD(1, int));
+        break;
+    case RECORD_SETLONGINTPARAM:
+        retcode = CSIPsetLongintParam(model, ARRAY(0, char),
+                                      FIELD(1, long long));
+        break;
+    case RECORD_SETREALPARAM:
+        retcode = CSIPsetRealParam(model, ARRAY(0, char), FIELD(1, double));
+        break;
+    case RECORD_SETCHARPARAM:
+        retcode = CSIPsetCharParam(model, ARRAY(0, char), (char) FIELD(1, int));
+        break;
+    case RECORD_SETSTRINGPARAM:
+        retcode = CSIPsetStringParam(model, ARRAY(0, char), ARRAY(1, char));
+        break;
+    case RECORD_SETDETERMINISTIC:
+        retcode = CSIPsetDeterministic(model, FIELD(0, int));
+        break;
+    case RECORD_SETINITIALSOL:
+        retcode = CSIPsetInitialSolution(model, ARRAY(0, double));
+        break;
+    case RECORD_SETINITIALSOLREPAIR:
+        retcode = CSIPsetInitialSolutionRepair(model, FIELD(0, double));
+        break;
+    case RECORD_POLISH:
+        retcode = CSIPpolish(model, FIELD(0, double));
+        break;
+    case RECORD_SETMESSAGEPREFIX:
+        retcode = CSIPsetMessagePrefix(model, ARRAY(0, char));
+        break;
+    case RECORD_ADDQUADCONSS:
+        retcode = CSIPaddQuadConss(model, f[0].n - 1, ARRAY(0, int),
+                                   ARRAY(1, int), ARRAY(2, double), f[3].n, ARRAY(3, int),
+                                   ARRAY(4, int), ARRAY(5, int), ARRAY(6, double),
+                                   ARRAY(7, double), ARRAY(8, double), NULL);
+        break;
+    case RECORD_CHGLINCONSSIDES:
+        retcode = chgLinConsSides(model, FIELD(0, int), FIELD(1, double),
+                                  FIELD(2, double));
+        break;
+    case RECORD_ADDLAZYCALLBACK:
+        // one callback replays the constraints of all recorded callbacks
+        if (!*lazyadded)
+        {
+            retcode = CSIPaddLazyCallback(model, replayLazyCallback, replay);
+            *lazyadded = TRUE;
+        }
+        break;
+    case RECORD_ADDHEURCALLBACK:
+        if (!*heuradded)
+        {
+            retcode = CSIPaddHeuristicCallback(model, replayHeurCallback, replay);
+            *heuradded = TRUE;
+        }
+        break;
+    case RECORD_SOLVED:
+        SCIPinfoMessage(model->scip, NULL, "replay: recorded status %d, %lld "
+                        "nodes, %.2fs, objective %g\n", FIELD(0, int),
+                        FIELD(1, long long), FIELD(2, double), FIELD(3, double));
+        SCIPinfoMessage(model->scip, NULL, "replay: replayed status %d, %lld "
+                        "nodes, %.2fs, objective %g\n", CSIPgetStatus(model),
+                        (long long) SCIPgetNNodes(model->scip),
+                        SCIPgetSolvingTime(model->scip),
+                        SCIPgetBestSol(model->scip) != NULL ? CSIPgetObjValue(model) : NAN);
+        break;
+    case RECORD_LAZYCONS:
+    case RECORD_HEURSOL:
+        // events, used by the replay callbacks
+        break;
+    default:
+        return CSIP_RETCODE_ERROR;
+    }
 
-    SCIP_in_CSIP(SCIPsetHeurFree(scip, heur, heurFreeUser));
-    model->nheur += 1;
+#undef FIELD
+#undef ARRAY
 
-    return CSIP_RETCODE_OK;
+    return retcode;
 }
 
-/*
- *  Message handler with a prefix
- */
-
-
-struct SCIP_MessagehdlrData
+// read all entries of a recording, events of a solve are recorded after its
+// call
+static
+CSIP_RETCODE readReplay(FILE *file, struct replay_data *replay)
 {
-    char* prefix;
-};
+    SCIP_Bool eof = FALSE;
+    CSIP_RETCODE retcode;
 
-static void logMessage(
-    SCIP_MESSAGEHDLR* messagehdlr, FILE* file, const char* msg)
-{
-    SCIP_MESSAGEHDLRDATA* messagehdlrdata;
-    messagehdlrdata = SCIPmessagehdlrGetData(messagehdlr);
+    replay->entriessize = INITIALSIZE;
+    replay->entries = (struct record_entry *) malloc(replay->entriessize *
+                      sizeof(struct record_entry));
+    if (replay->entries == NULL)
+    {
+        return CSIP_RETCODE_NOMEMORY;
+    }
+    while (!eof)
+    {
+        if (replay->nentries >= replay->entriessize)
+        {
+            struct record_entry *entries;
 
-    fputs(messagehdlrdata->prefix, file);
-    fputs(msg, file);
-    fflush(file);
-    return;
+            entries = (struct record_entry *) realloc(replay->entries,
+                      GROWFACTOR * replay->entriessize * sizeof(struct record_entry));
+            if (entries == NULL)
+            {
+                return CSIP_RETCODE_NOMEMORY;
+            }
+            replay->entries = entries;
+            replay->entriessize = GROWFACTOR * replay->entriessize;
+        }
+        retcode = readRecordEntry(file, &replay->entries[replay->nentries], &eof);
+        if (retcode != CSIP_RETCODE_OK)
+        {
+            return retcode;
+        }
+        if (!eof)
+        {
+            ++(replay->nentries);
+        }
+    }
+
+    return CSIP_RETCODE_OK;
 }
 
-static SCIP_DECL_MESSAGEHDLRFREE(messageHdlrFree)
+static
+CSIP_RETCODE replayAll(CSIP_MODEL *model, struct replay_data *replay)
 {
-    SCIP_MESSAGEHDLRDATA* messagehdlrdata = SCIPmessagehdlrGetData(messagehdlr);
-    free(messagehdlrdata->prefix);
-    SCIPfreeMemory(NULL, &messagehdlrdata);
-    return SCIP_OKAY;
+    SCIP_Bool lazyadded = FALSE;
+    SCIP_Bool heuradded = FALSE;
+    CSIP_RETCODE retcode = CSIP_RETCODE_OK;
+
+    for (int i = 0; i < replay->nentries && retcode == CSIP_RETCODE_OK; ++i)
+    {
+        if (replay->entries[i].op == RECORD_SOLVE)
+        {
+            replay->first = i + 1;
+            replay->last = i + 1;
+            while (replay->last < replay->nentries
+                    && replay->entries[replay->last].op != RECORD_SOLVED)
+            {
+                ++(replay->last);
+            }
+            replay->sols_added = FALSE;
+            retcode = CSIPsolve(model);
+        }
+        else
+        {
+            retcode = replayEntry(model, replay, i, &lazyadded, &heuradded);
+        }
+    }
+
+    // further solves of the model don't replay any events
+    replay->first = 0;
+    replay->last = 0;
+
+    return retcode;
 }
 
-CSIP_RETCODE CSIPsetMessagePrefix(CSIP_MODEL *model, const char* prefix)
+CSIP_RETCODE CSIPreplayRecording(const char *path, CSIP_MODEL **modelptr)
 {
-    SCIP_MESSAGEHDLR* messagehdlr = NULL;
-    SCIP_MESSAGEHDLRDATA* messagehdlrdata = NULL;
+    FILE *file;
+    int header[2];
+    struct replay_data *replay;
+    CSIP_RETCODE retcode;
+
+    *modelptr = NULL;
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return CSIP_RETCODE_ERROR;
+    }
+    if (fread(header, sizeof(int), 2, file) != 2 || header[0] != RECORD_MAGIC
+            || header[1] != RECORD_VERSION)
+    {
+        fclose(file);
+        return CSIP_RETCODE_ERROR;
+    }
 
-    SCIP_in_CSIP(SCIPallocMemory(NULL, &messagehdlrdata));
-    messagehdlrdata->prefix = strDup(prefix);
-    SCIP_in_CSIP(SCIPmessagehdlrCreate(&messagehdlr, FALSE, NULL, FALSE,
-                                       logMessage, logMessage, logMessage,
-                                       messageHdlrFree, messagehdlrdata));
+    // the model owns the entries, since its callbacks refer to them
+    retcode = CSIPcreateModel(modelptr);
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        fclose(file);
+        return retcode;
+    }
+    replay = (struct replay_data *) calloc(1, sizeof(struct replay_data));
+    if (replay == NULL)
+    {
+        retcode = CSIP_RETCODE_NOMEMORY;
+    }
+    else
+    {
+        (*modelptr)->replay = replay;
+        retcode = readReplay(file, replay);
+    }
+    fclose(file);
 
-    SCIP_in_CSIP(SCIPsetMessagehdlr(model->scip, messagehdlr));
-    SCIP_in_CSIP(SCIPmessagehdlrRelease(&messagehdlr));
+    if (retcode == CSIP_RETCODE_OK)
+    {
+        retcode = replayAll(*modelptr, replay);
+    }
 
-    return CSIP_RETCODE_OK;
+    // a truncated or corrupt file, or a recorded call that fails on replay
+    if (retcode != CSIP_RETCODE_OK)
+    {
+        CSIPfreeModel(*modelptr);
+        *modelptr = NULL;
+    }
+
+    return retcode;
 }
@@ -1,6 +1,12 @@
+// for CPU affinity of threads
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 #include <csip.h>
 
@@ -1198,6 +1204,1464 @@ static void test_heurcb()
 }
 
 
+// checks the progress estimate during the solve; userdata counts bad ones
+CSIP_RETCODE progress_lazy_cb(CSIP_MODEL *m, CSIP_LAZYDATA *lazydata,
+                              void *userdata)
+{
+    int *nbad = (int *) userdata;
+    CSIP_PROGRESS est;
+
+    CHECK(CSIPgetProgressEstimate(m, &est));
+    if (est.treeweight < 0.0 || est.treeweight > 1.0 || est.gapclosed < 0.0
+            || est.gapclosed > 1.0
+            || (est.treesize != -1.0 && est.treesize < est.nnodes))
+    {
+        ++(*nbad);
+    }
+    return CSIP_RETCODE_OK;
+}
+
+static void test_progress()
+{
+    // same knapsack as in test_mip, check progress estimate during and after
+    // solve
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    CSIP_PROGRESS est;
+    CSIP_MODEL *m;
+    int nbad = 0;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+    CHECK(CSIPaddLazyCallback(m, progress_lazy_cb, &nbad));
+
+    CHECK(CSIPgetProgressEstimate(m, &est));
+    mu_assert_near("Wrong tree weight!", est.treeweight, 0.0);
+    mu_assert_near("Wrong remaining time!", est.remainingtime, -1.0);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+
+    CHECK(CSIPgetProgressEstimate(m, &est));
+    mu_assert_near("Wrong tree weight!", est.treeweight, 1.0);
+    mu_assert_near("Wrong gap closed!", est.gapclosed, 1.0);
+    mu_assert_near("Wrong remaining time!", est.remainingtime, 0.0);
+    mu_assert("No nodes counted!", est.nnodes >= 1);
+    mu_assert_int("Bad estimate during solve!", nbad, 0);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_scenarios()
+{
+    // knapsack of test_mip, solved for a few scenarios
+    //   0: no change, sol -16
+    //   1: capacity 2, sol -7
+    //   2: x_4 <= 0, sol -9
+    //   3: like 1 again, to check that scenarios were reverted
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    int considx[] = {0};
+    double rhs[] = {2.0};
+    int varidx[] = {3};
+    double ub[] = {0.0};
+    double solution[5];
+    CSIP_SCENARIO deltas[4] = {{0}};
+    CSIP_SCENARIO_RESULT results[4] = {{0}};
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+
+    deltas[1].nsides = 1;
+    deltas[1].consindices = considx;
+    deltas[1].rhs = rhs;
+    deltas[2].nbounds = 1;
+    deltas[2].boundindices = varidx;
+    deltas[2].upperbounds = ub;
+    deltas[3] = deltas[1];
+    results[2].values = solution;
+
+    // both workers on the first CPU
+    int cpubeg[] = {0, 1};
+    int cpus[] = {0};
+    CHECK(CSIPsetWorkerCPUs(m, 1, cpubeg, cpus));
+
+    CHECK(CSIPsolveScenarios(m, 4, deltas, 2, results));
+
+    for (int i = 0; i < 4; i++)
+    {
+        mu_assert_int("Wrong status!", results[i].status, CSIP_STATUS_OPTIMAL);
+    }
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -16.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -7.0);
+    mu_assert_near("Wrong objective value!", results[2].objvalue, -9.0);
+    mu_assert_near("Wrong objective value!", results[3].objvalue, -7.0);
+    mu_assert_near("Wrong solution!", solution[3], 0.0);
+
+    // base model is unchanged
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -16.0);
+
+    // capacity -1 is infeasible, there is no objective value
+    rhs[0] = -1.0;
+    CHECK(CSIPsolveScenarios(m, 1, &deltas[1], 1, results));
+    mu_assert_int("Wrong status!", results[0].status, CSIP_STATUS_INFEASIBLE);
+    mu_assert("Objective value without solution!",
+              results[0].objvalue != results[0].objvalue);
+
+    // weight exactly 12 moves the lhs above the old rhs, sol -15; reverting
+    // moves the rhs below it again, then the base is solved
+    double exact[] = {12.0};
+    deltas[0].nsides = 1;
+    deltas[0].consindices = considx;
+    deltas[0].lhs = exact;
+    deltas[0].rhs = exact;
+    deltas[1] = (CSIP_SCENARIO) {0};
+    CHECK(CSIPsolveScenarios(m, 2, deltas, 1, results));
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -15.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -16.0);
+
+    // bad scenarios are rejected before anything is solved
+    int badconsidx[] = {1};
+    deltas[1].nsides = 1;
+    deltas[1].consindices = badconsidx;
+    deltas[1].rhs = rhs;
+    mu_assert_int("Scenario with missing constraint!",
+                  CSIPsolveScenarios(m, 2, deltas, 1, results),
+                  CSIP_RETCODE_ERROR);
+    deltas[0].rhs = rhs;
+    mu_assert_int("Scenario with lhs above rhs!",
+                  CSIPsolveScenarios(m, 1, deltas, 1, results),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_workercpus()
+{
+    // pin both workers to the last CPU we may use: all scenarios are solved
+    // there, and the calling thread gets its affinity back afterwards
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    CSIP_SCENARIO deltas[8] = {{0}};
+    CSIP_SCENARIO_RESULT results[8] = {{0}};
+    cpu_set_t before;
+    cpu_set_t after;
+    int cpubeg[] = {0, 1};
+    int cpus[1];
+    CSIP_MODEL *m;
+
+    mu_assert("Can't get affinity!",
+              sched_getaffinity(0, sizeof(cpu_set_t), &before) == 0);
+    for (int c = 0; c < CPU_SETSIZE; c++)
+    {
+        if (CPU_ISSET(c, &before))
+        {
+            cpus[0] = c;
+        }
+    }
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+    CHECK(CSIPsetWorkerCPUs(m, 1, cpubeg, cpus));
+
+    CHECK(CSIPsolveScenarios(m, 8, deltas, 2, results));
+    for (int i = 0; i < 8; i++)
+    {
+        mu_assert_near("Wrong objective value!", results[i].objvalue, -16.0);
+        mu_assert_int("Solved on wrong CPU!", results[i].cpu, cpus[0]);
+    }
+
+    mu_assert("Can't get affinity!",
+              sched_getaffinity(0, sizeof(cpu_set_t), &after) == 0);
+    mu_assert("Affinity not restored!", CPU_EQUAL(&before, &after));
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_benders()
+{
+    // master: min 3x + eta, x binary
+    // sub:    min y + 10u
+    //         y + u >= 1
+    //         y <= z, z = x (linking)
+    //         y, u >= 0, 0 <= z <= 1
+    // opening (x = 1) costs 3 + 1, not opening costs 10
+    CSIP_MODEL *master;
+    CSIP_MODEL *sub;
+    int xidx;
+    int etaidx;
+    int zidx = 2;
+    int subindices[] = {0, 1, 2};
+    double subobj[] = {1.0, 10.0};
+    double demandcoef[] = {1.0, 1.0};
+    double linkcoef[] = {1.0, -1.0};
+    int linkindices[] = {0, 2};
+    double objcoef[] = {3.0};
+    double lb[] = {0.0};
+    double solution[2];
+
+    CHECK(CSIPcreateModel(&master));
+    CHECK(CSIPsetIntParam(master, "display/verblevel", 2));
+    CHECK(CSIPaddVar(master, 0.0, 1.0, CSIP_VARTYPE_BINARY, &xidx));
+    CHECK(CSIPsetObj(master, 1, &xidx, objcoef));
+
+    CHECK(CSIPcreateModel(&sub));
+    CHECK(CSIPsetIntParam(sub, "display/verblevel", 0));
+    CHECK(CSIPaddVar(sub, 0.0, INFINITY, CSIP_VARTYPE_CONTINUOUS, NULL)); // y
+    CHECK(CSIPaddVar(sub, 0.0, INFINITY, CSIP_VARTYPE_CONTINUOUS, NULL)); // u
+    CHECK(CSIPaddVar(sub, 0.0, 1.0, CSIP_VARTYPE_CONTINUOUS, NULL));      // z
+    CHECK(CSIPsetObj(sub, 2, subindices, subobj));
+    CHECK(CSIPaddLinCons(sub, 2, subindices, demandcoef, 1.0, INFINITY, NULL));
+    CHECK(CSIPaddLinCons(sub, 2, linkindices, linkcoef, -INFINITY, 0.0, NULL));
+
+    CHECK(CSIPbenders(master, 1, &sub, 1, &xidx, &zidx, lb, 1, &etaidx));
+    mu_assert_int("Wrong eta index!", etaidx, 1);
+
+    CHECK(CSIPsolve(master));
+    mu_assert_int("Wrong status!", CSIPgetStatus(master), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(master), 4.0);
+
+    CHECK(CSIPgetVarValues(master, solution));
+    mu_assert_near("Wrong solution!", solution[0], 1.0);
+    mu_assert_near("Wrong solution!", solution[1], 1.0);
+
+    CHECK(CSIPfreeModel(master));
+    CHECK(CSIPfreeModel(sub));
+}
+
+static void test_benders_duals()
+{
+    // master: min x + eta, 0 <= x <= 10
+    // sub:    min 2u
+    //         y + u >= 4
+    //         y <= z, z = x (linking)
+    //         y, u >= 0
+    // sub costs 2 (4 - x) for x <= 4, so the optimum is x = 4 with value 4;
+    // the cut at x = 0 needs the dual -2 of the linking row to get there
+    CSIP_MODEL *master;
+    CSIP_MODEL *sub;
+    int xidx;
+    int etaidx;
+    int zidx = 2;
+    int uidx = 1;
+    int subindices[] = {0, 1};
+    double subobj[] = {2.0};
+    double demandcoef[] = {1.0, 1.0};
+    double linkcoef[] = {1.0, -1.0};
+    int linkindices[] = {0, 2};
+    double objcoef[] = {1.0};
+    double lb[] = {0.0};
+    double solution[2];
+
+    CHECK(CSIPcreateModel(&master));
+    CHECK(CSIPsetIntParam(master, "display/verblevel", 2));
+    CHECK(CSIPaddVar(master, 0.0, 10.0, CSIP_VARTYPE_CONTINUOUS, &xidx));
+    CHECK(CSIPsetObj(master, 1, &xidx, objcoef));
+
+    CHECK(CSIPcreateModel(&sub));
+    CHECK(CSIPsetIntParam(sub, "display/verblevel", 0));
+    CHECK(CSIPaddVar(sub, 0.0, INFINITY, CSIP_VARTYPE_CONTINUOUS, NULL)); // y
+    CHECK(CSIPaddVar(sub, 0.0, INFINITY, CSIP_VARTYPE_CONTINUOUS, NULL)); // u
+    CHECK(CSIPaddVar(sub, -INFINITY, INFINITY, CSIP_VARTYPE_CONTINUOUS,
+                     NULL));                                             // z
+    CHECK(CSIPsetObj(sub, 1, &uidx, subobj));
+    CHECK(CSIPaddLinCons(sub, 2, subindices, demandcoef, 4.0, INFINITY, NULL));
+    CHECK(CSIPaddLinCons(sub, 2, linkindices, linkcoef, -INFINITY, 0.0, NULL));
+
+    // a link to a missing sub variable is rejected before anything changes
+    int badidx = 3;
+    mu_assert_int("Missing link variable accepted!",
+                  CSIPbenders(master, 1, &sub, 1, &xidx, &badidx, lb, 1, &etaidx),
+                  CSIP_RETCODE_ERROR);
+    mu_assert_int("Master was changed!", CSIPgetNumVars(master), 1);
+    mu_assert_int("Subproblem was changed!", CSIPgetNumVars(sub), 3);
+    mu_assert_int("Subproblem was changed!", CSIPgetNumConss(sub), 2);
+
+    CHECK(CSIPbenders(master, 1, &sub, 1, &xidx, &zidx, lb, 1, &etaidx));
+
+    CHECK(CSIPsolve(master));
+    mu_assert_int("Wrong status!", CSIPgetStatus(master), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(master), 4.0);
+
+    CHECK(CSIPgetVarValues(master, solution));
+    mu_assert_near("Wrong solution!", solution[0], 4.0);
+    mu_assert_near("Wrong solution!", solution[1], 0.0);
+
+    CHECK(CSIPfreeModel(master));
+    CHECK(CSIPfreeModel(sub));
+}
+
+static void test_replaceobj()
+{
+    // 0 <= x, y, z <= 1, x + y + z <= 2
+    // max x + y, then replace by max z
+    CSIP_MODEL *m;
+    int indices[] = {0, 1, 2};
+    double coefs[] = {1.0, 1.0, 1.0};
+    double solution[3];
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    }
+    CHECK(CSIPaddLinCons(m, 3, indices, coefs, -INFINITY, 2.0, NULL));
+    CHECK(CSIPsetSenseMaximize(m));
+
+    CHECK(CSIPsetObj(m, 2, indices, coefs));
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 2.0);
+
+    CHECK(CSIPreplaceObj(m, 1, indices + 2, coefs));
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 1.0);
+    CHECK(CSIPgetVarValues(m, solution));
+    mu_assert_near("Wrong solution!", solution[2], 1.0);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_recording()
+{
+    // record test_lazy2, then replay without the callback
+    int objindices[] = {0};
+    double objcoef[] = { -1.0};
+    double solution[1];
+    const char *path = "csip_test_recording.bin";
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPstartRecording(m, path));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, -INFINITY, 100.5, CSIP_VARTYPE_INTEGER, NULL));
+    CHECK(CSIPsetObj(m, 1, objindices, objcoef));
+
+    struct MyData userdata = { 10, &solution[0] };
+    CHECK(CSIPaddLazyCallback(m, lazy_callback2, &userdata));
+
+    // rejected calls are not recorded
+    mu_assert_int("Negative budget accepted!",
+                  CSIPsetInitialSolutionRepair(m, -1.0), CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -10.0);
+    CHECK(CSIPstopRecording(m));
+    CHECK(CSIPfreeModel(m));
+
+    CHECK(CSIPreplayRecording(path, &m));
+    mu_assert_int("Wrong number of vars!", CSIPgetNumVars(m), 1);
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -10.0);
+    CHECK(CSIPfreeModel(m));
+
+    // a truncated recording is an error
+    FILE *file = fopen(path, "rb");
+    char buffer[4096];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    file = fopen(path, "wb");
+    fwrite(buffer, 1, size - 5, file);
+    fclose(file);
+    mu_assert_int("Truncated recording replayed!",
+                  CSIPreplayRecording(path, &m), CSIP_RETCODE_ERROR);
+    mu_assert("Model of failed replay!", m == NULL);
+
+    remove(path);
+}
+
+static void test_sweeprhs()
+{
+    // knapsack of test_mip with capacities 2, 10, 2 again and -1
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    int considx[1];
+    double rhsvalues[] = {2.0, 10.0, 2.0, -1.0};
+    CSIP_SCENARIO_RESULT results[4] = {{0}};
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0,
+                         &considx[0]));
+
+    CHECK(CSIPsweepRHS(m, 1, considx, 4, rhsvalues, results));
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -7.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -16.0);
+    mu_assert_near("Wrong objective value!", results[2].objvalue, -7.0);
+    mu_assert_int("Wrong status!", results[3].status, CSIP_STATUS_INFEASIBLE);
+    mu_assert("Objective value without solution!",
+              results[3].objvalue != results[3].objvalue);
+
+    // original capacity is restored
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -16.0);
+
+    // with a repair budget, the solution for capacity 10 is repaired to fit
+    // capacity 2
+    CHECK(CSIPsetInitialSolutionRepair(m, 10.0));
+    CHECK(CSIPsweepRHS(m, 1, considx, 2, &rhsvalues[1], results));
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -16.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -7.0);
+    mu_assert_int("Wrong initial solution status!",
+                  CSIPgetInitialSolutionStatus(m), CSIP_INITSOL_REPAIRED);
+
+    // a missing constraint is an error, nothing is solved
+    considx[0] = 1;
+    mu_assert_int("Missing constraint accepted!",
+                  CSIPsweepRHS(m, 1, considx, 1, rhsvalues, results),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_quadconss()
+{
+    /*
+      min x + y
+      s.t. 0.5 x*y + 0.5 y*x >= 1
+           x - y == 0
+           0 <= x, y <= 10
+      -> {1, 1}
+      recorded and replayed
+     */
+    int linbeg[] = {0, 0, 2};
+    int linindices[] = {0, 1};
+    double lincoefs[] = {1.0, -1.0};
+    int quadcons[] = {0, 0};
+    int quadrow[] = {0, 1};
+    int quadcol[] = {1, 0};
+    double quadcoefs[] = {0.5, 0.5};
+    double lhs[] = {1.0, 0.0};
+    double rhs[] = {INFINITY, 0.0};
+    int objindices[] = {0, 1};
+    double objcoefs[] = {1.0, 1.0};
+    int badcons[] = {0, 2};
+    int badlinindices[] = {0, 2};
+    int badlinbeg[] = {0, 2, 1};
+    double solution[2];
+    const char *path = "csip_test_quadconss.bin";
+    int idx;
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPstartRecording(m, path));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, 0.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPaddVar(m, 0.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPsetObj(m, 2, objindices, objcoefs));
+
+    // a term of a third constraint is an error, nothing is added
+    mu_assert_int("Term of missing constraint accepted!",
+                  CSIPaddQuadConss(m, 2, linbeg, linindices, lincoefs, 2, badcons,
+                                   quadrow, quadcol, quadcoefs, lhs, rhs, &idx),
+                  CSIP_RETCODE_ERROR);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 0);
+
+    // so are a missing variable and a decreasing linbeg
+    mu_assert_int("Missing variable accepted!",
+                  CSIPaddQuadConss(m, 2, linbeg, badlinindices, lincoefs, 2,
+                                   quadcons, quadrow, quadcol, quadcoefs, lhs,
+                                   rhs, &idx),
+                  CSIP_RETCODE_ERROR);
+    mu_assert_int("Decreasing linbeg accepted!",
+                  CSIPaddQuadConss(m, 2, badlinbeg, linindices, lincoefs, 2,
+                                   quadcons, quadrow, quadcol, quadcoefs, lhs,
+                                   rhs, &idx),
+                  CSIP_RETCODE_ERROR);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 0);
+
+    CHECK(CSIPaddQuadConss(m, 2, linbeg, linindices, lincoefs, 2, quadcons,
+                           quadrow, quadcol, quadcoefs, lhs, rhs, &idx));
+    mu_assert_int("Wrong constraint index!", idx, 0);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 2);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 2.0);
+    CHECK(CSIPgetVarValues(m, solution));
+    mu_assert("Wrong solution!", fabs(solution[0] - 1.0) < 0.01);
+    mu_assert("Wrong solution!", fabs(solution[1] - 1.0) < 0.01);
+    CHECK(CSIPstopRecording(m));
+    CHECK(CSIPfreeModel(m));
+
+    CHECK(CSIPreplayRecording(path, &m));
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 2);
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 2.0);
+    CHECK(CSIPfreeModel(m));
+
+    remove(path);
+}
+
+static void test_sosbatch()
+{
+    // max a + 2b + 3c + 4d + 5e + 6f + 7g
+    //     SOS1(a, b), SOS1(c, d) in one batch
+    //     SOS2(e, f, g) in another
+    //     0 <= a, ..., g <= 1
+    //
+    // sol -> (0, 1, 0, 1, 0, 1, 1)
+
+    CSIP_MODEL *m;
+    int objindices[] = {0, 1, 2, 3, 4, 5, 6};
+    double objcoef[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
+    int sos1beg[] = {0, 2, 4};
+    int sos1indices[] = {0, 1, 2, 3};
+    double sos1weights[] = {1.0, 2.0, 1.0, 2.0};
+    int sos2beg[] = {0, 3};
+    int sos2indices[] = {4, 5, 6};
+    double expected[] = {0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 1.0};
+    double solution[7];
+    int idx;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 7; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    }
+    CHECK(CSIPaddSOSBatch(m, CSIP_SOSTYPE_SOS1, 2, sos1beg, sos1indices,
+                          sos1weights, &idx));
+    mu_assert_int("Wrong constraint index!", idx, 0);
+    CHECK(CSIPaddSOSBatch(m, CSIP_SOSTYPE_SOS2, 1, sos2beg, sos2indices, NULL,
+                          &idx));
+    mu_assert_int("Wrong constraint index!", idx, 2);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 3);
+    CHECK(CSIPsetSenseMaximize(m));
+    CHECK(CSIPsetObj(m, 7, objindices, objcoef));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 19.0);
+    CHECK(CSIPgetVarValues(m, solution));
+    for (int i = 0; i < 7; i++)
+    {
+        mu_assert_near("Wrong solution!", solution[i], expected[i]);
+    }
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_nonlinconss()
+{
+    // max x + y
+    //     x^2 <= 4
+    //     y^2 <= 9
+    //
+    // sol -> (2, 3)
+
+    CSIP_MODEL *m;
+    int objindices[] = {0, 1};
+    double objcoef[] = {1.0, 1.0};
+    int consbeg[] = {0, 3, 6};
+    CSIP_OP ops[] = {VARIDX, CONST, POW, VARIDX, CONST, POW};
+    int children[] = {0, 0, 0, 1, 1, 0, 0, 1};
+    int begin[] = {0, 1, 2, 4, 5, 6, 8};
+    double values[] = {2.0};
+    double lhs[] = { -INFINITY, -INFINITY};
+    double rhs[] = {4.0, 9.0};
+    double solution[2];
+    int idx;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+
+    // a missing variable in the second expression, or a child after its op
+    // in the first, is an error and adds neither constraint
+    children[4] = 2;
+    mu_assert_int("Missing variable accepted!",
+                  CSIPaddNonLinConss(m, 2, consbeg, ops, children, begin, values,
+                                     lhs, rhs, &idx),
+                  CSIP_RETCODE_ERROR);
+    children[4] = 1;
+    children[2] = 2;
+    mu_assert_int("Child after its op accepted!",
+                  CSIPaddNonLinConss(m, 2, consbeg, ops, children, begin, values,
+                                     lhs, rhs, &idx),
+                  CSIP_RETCODE_ERROR);
+    children[2] = 0;
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 0);
+
+    CHECK(CSIPaddNonLinConss(m, 2, consbeg, ops, children, begin, values, lhs,
+                             rhs, &idx));
+    mu_assert_int("Wrong constraint index!", idx, 0);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 2);
+    CHECK(CSIPsetSenseMaximize(m));
+    CHECK(CSIPsetObj(m, 2, objindices, objcoef));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 5.0);
+    CHECK(CSIPgetVarValues(m, solution));
+    mu_assert("Wrong solution!", fabs(solution[0] - 2.0) < 0.01);
+    mu_assert("Wrong solution!", fabs(solution[1] - 3.0) < 0.01);
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_exprtemplate()
+{
+    // max x + y
+    //     x^2 <= 4
+    //     y^2 <= 9
+    //
+    // sol -> (2, 3)
+
+    CSIP_MODEL *m;
+    int objindices[] = {0, 1};
+    double objcoef[] = {1.0, 1.0};
+    CSIP_OP ops[] = {VARIDX, CONST, POW};
+    int children[] = {0, 0, 0, 1};
+    int badchildren[] = {1, 0, 0, 1};
+    int begin[] = {0, 1, 2, 4};
+    double values[] = {2.0};
+    int slotvars[] = {0, 1};
+    double lhs[] = { -INFINITY, -INFINITY};
+    double rhs[] = {4.0, 9.0};
+    int tid;
+    int idx;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+
+    // slot 1 does not exist
+    mu_assert_int("Invalid template accepted!",
+                  CSIPregisterExprTemplate(m, 3, ops, badchildren, begin, values,
+                                           1, &tid), CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPregisterExprTemplate(m, 3, ops, children, begin, values, 1,
+                                   &tid));
+    mu_assert_int("Wrong template index!", tid, 0);
+    CHECK(CSIPaddNonLinConsFromTemplate(m, tid, 2, slotvars, NULL, lhs, rhs,
+                                        &idx));
+    mu_assert_int("Wrong constraint index!", idx, 0);
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 2);
+    CHECK(CSIPsetSenseMaximize(m));
+    CHECK(CSIPsetObj(m, 2, objindices, objcoef));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 5.0);
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_curvature()
+{
+    // min exp(x)
+    //     x^2 <= 4 (convex)
+    //     x + y <= 1
+    //
+    // sol -> x = -2
+
+    CSIP_MODEL *m;
+    CSIP_OP consops[] = {VARIDX, CONST, POW};
+    int conschildren[] = {0, 0, 0, 1};
+    int consbegin[] = {0, 1, 2, 4};
+    double consvalues[] = {2.0};
+    CSIP_OP objops[] = {VARIDX, EXP};
+    int objchildren[] = {0, 0};
+    int objbegin[] = {0, 1, 2};
+    int linindices[] = {0, 1};
+    double lincoefs[] = {1.0, 1.0};
+    int nonlinidx;
+    int linidx;
+    int assumeconvex;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    CHECK(CSIPaddNonLinCons(m, 3, consops, conschildren, consbegin, consvalues,
+                            -INFINITY, 4.0, &nonlinidx));
+    CHECK(CSIPaddLinCons(m, 2, linindices, lincoefs, -INFINITY, 1.0, &linidx));
+    CHECK(CSIPsetNonlinearObj(m, 2, objops, objchildren, objbegin, NULL));
+
+    CHECK(CSIPsetNonLinConsCurvature(m, nonlinidx, CSIP_CURVATURE_CONVEX));
+    CHECK(CSIPsetNonlinearObjCurvature(m, CSIP_CURVATURE_CONVEX));
+    mu_assert_int("Curvature of linear constraint accepted!",
+                  CSIPsetNonLinConsCurvature(m, linidx, CSIP_CURVATURE_CONVEX),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), exp(-2.0));
+    CHECK(CSIPgetBoolParam(m, "constraints/nonlinear/assumeconvex",
+                           &assumeconvex));
+    mu_assert_int("Convexity not assumed!", assumeconvex, 1);
+
+    // without a hint for the constraint, the previous value is restored
+    CHECK(CSIPsetNonLinConsCurvature(m, nonlinidx, CSIP_CURVATURE_UNKNOWN));
+    CHECK(CSIPsolve(m));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), exp(-2.0));
+    CHECK(CSIPgetBoolParam(m, "constraints/nonlinear/assumeconvex",
+                           &assumeconvex));
+    mu_assert_int("Convexity still assumed!", assumeconvex, 0);
+
+    // and don't override the user
+    CHECK(CSIPsetBoolParam(m, "constraints/nonlinear/assumeconvex", 1));
+    CHECK(CSIPsolve(m));
+    CHECK(CSIPgetBoolParam(m, "constraints/nonlinear/assumeconvex",
+                           &assumeconvex));
+    mu_assert_int("User value overridden!", assumeconvex, 1);
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_orbitope()
+{
+    // assign 2 jobs to 3 identical machines, at most one job per machine
+    // min sum_mj (j + 1) x_mj
+    //     sum_m x_mj == 1  for all jobs j
+    //     sum_j x_mj <= 1  for all machines m
+    //
+    // x_mj is variable 2 * m + j; recorded and replayed
+
+    CSIP_MODEL *m;
+    int blockvars[] = {0, 1, 2, 3, 4, 5};
+    double objcoef[] = {1.0, 2.0, 1.0, 2.0, 1.0, 2.0};
+    double ones[] = {1.0, 1.0, 1.0};
+    int varmatrix[] = {0, 2, 4, 1, 3, 5};
+    int duplicates[] = {0, 1, 2, 3, 2, 5};
+    const char *path = "csip_test_orbitope.bin";
+    int idx;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPstartRecording(m, path));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 6; ++i)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 6, blockvars, objcoef));
+
+    // rows are missing
+    mu_assert_int("Orbitope without rows accepted!",
+                  CSIPaddSymmetricBlocks(m, 3, 2, blockvars, &idx),
+                  CSIP_RETCODE_ERROR);
+
+    for (int j = 0; j < 2; ++j)
+    {
+        int indices[] = {j, 2 + j, 4 + j};
+        CHECK(CSIPaddLinCons(m, 3, indices, ones, 1.0, 1.0, NULL));
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        int indices[] = {2 * i, 2 * i + 1};
+        CHECK(CSIPaddLinCons(m, 2, indices, ones, -INFINITY, 1.0, NULL));
+    }
+
+    // a variable in two blocks
+    mu_assert_int("Duplicate block variable accepted!",
+                  CSIPaddSymmetricBlocks(m, 3, 2, duplicates, &idx),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPaddSymmetricBlocks(m, 3, 2, blockvars, &idx));
+    mu_assert_int("Wrong constraint index!", idx, 5);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 3.0);
+    CHECK(CSIPstopRecording(m));
+    CHECK(CSIPfreeModel(m));
+
+    CHECK(CSIPreplayRecording(path, &m));
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 6);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 3.0);
+    CHECK(CSIPfreeModel(m));
+
+    // same with an explicit orbitope
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPstartRecording(m, path));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 6; ++i)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 6, blockvars, objcoef));
+    for (int j = 0; j < 2; ++j)
+    {
+        int indices[] = {j, 2 + j, 4 + j};
+        CHECK(CSIPaddLinCons(m, 3, indices, ones, 1.0, 1.0, NULL));
+    }
+    mu_assert_int("Duplicate orbitope variable accepted!",
+                  CSIPaddOrbitope(m, 2, 3, duplicates,
+                                  CSIP_ORBITOPETYPE_PARTITIONING, NULL),
+                  CSIP_RETCODE_ERROR);
+    CHECK(CSIPaddOrbitope(m, 2, 3, varmatrix, CSIP_ORBITOPETYPE_PARTITIONING,
+                          NULL));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 3.0);
+    CHECK(CSIPstopRecording(m));
+    CHECK(CSIPfreeModel(m));
+
+    CHECK(CSIPreplayRecording(path, &m));
+    mu_assert_int("Wrong number of conss!", CSIPgetNumConss(m), 3);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 3.0);
+    CHECK(CSIPfreeModel(m));
+
+    remove(path);
+}
+
+static void test_bounddisjunction()
+{
+    // min 2y - x
+    //     x <= 3 OR y >= 7
+    //     0 <= x, y <= 10, integer
+    //
+    // sol -> (3, 0)
+
+    CSIP_MODEL *m;
+    int indices[] = {0, 1};
+    double objcoef[] = { -1.0, 2.0};
+    CSIP_BOUNDTYPE boundtypes[] = {CSIP_BOUNDTYPE_UPPER, CSIP_BOUNDTYPE_LOWER};
+    double bounds[] = {3.0, 7.0};
+    double solution[2];
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, 0.0, 10.0, CSIP_VARTYPE_INTEGER, NULL));   // x
+    CHECK(CSIPaddVar(m, 0.0, 10.0, CSIP_VARTYPE_INTEGER, NULL));   // y
+    CHECK(CSIPsetObj(m, 2, indices, objcoef));
+    CHECK(CSIPaddBoundDisjunction(m, 2, indices, boundtypes, bounds, NULL));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -3.0);
+    CHECK(CSIPgetVarValues(m, solution));
+    mu_assert_near("Wrong solution!", solution[0], 3.0);
+    mu_assert_near("Wrong solution!", solution[1], 0.0);
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_cumulative()
+{
+    // min C
+    //     C >= s_j + 2 for all jobs j
+    //     3 jobs of duration 2 and demand 1 on a resource of capacity 1
+    //     0 <= s_j <= 10, integer
+    //
+    // sol -> C = 6
+
+    CSIP_MODEL *m;
+    int startvars[] = {0, 1, 2};
+    int durations[] = {2, 2, 2};
+    int demands[] = {1, 1, 1};
+    int objindices[] = {3};
+    double objcoef[] = {1.0};
+    double coefs[] = {1.0, -1.0};
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int j = 0; j < 3; ++j)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 10.0, CSIP_VARTYPE_INTEGER, NULL));
+    }
+    CHECK(CSIPaddVar(m, 0.0, 20.0, CSIP_VARTYPE_CONTINUOUS, NULL));   // C
+    for (int j = 0; j < 3; ++j)
+    {
+        int indices[] = {3, j};
+        CHECK(CSIPaddLinCons(m, 2, indices, coefs, 2.0, INFINITY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 1, objindices, objcoef));
+    CHECK(CSIPaddCumulative(m, 3, startvars, durations, demands, 1, NULL));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 6.0);
+    CHECK(CSIPfreeModel(m));
+}
+
+CSIP_RETCODE slow_lazy_cb(CSIP_MODEL *m, CSIP_LAZYDATA *lazydata,
+                          void *userdata)
+{
+    // busy until told to stop
+    while (!CSIPlazyShouldStop(lazydata));
+    return CSIP_RETCODE_OK;
+}
+
+CSIP_RETCODE slow_heur_cb(CSIP_MODEL *model, CSIP_HEURDATA *heurdata,
+                          void *userdata)
+{
+    while (!CSIPheurShouldStop(heurdata));
+    return CSIP_RETCODE_OK;
+}
+
+static void test_callbackbudget()
+{
+    // min x + y
+    //     x + y >= 1.5
+    //     x,y in [0, 3] integer
+    CSIP_MODEL *m;
+    int indices[] = {0, 1};
+    double coefs[] = {1.0, 1.0};
+    CSIP_CALLBACK_STATS stats;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPsetIntParam(m, "presolving/maxrounds", 0));
+    CHECK(CSIPaddVar(m, 0.0, 3.0, CSIP_VARTYPE_INTEGER, NULL));
+    CHECK(CSIPaddVar(m, 0.0, 3.0, CSIP_VARTYPE_INTEGER, NULL));
+    CHECK(CSIPaddLinCons(m, 2, indices, coefs, 1.5, INFINITY, NULL));
+    CHECK(CSIPsetObj(m, 2, indices, coefs));
+
+    CHECK(CSIPaddLazyCallback(m, slow_lazy_cb, NULL));
+    CHECK(CSIPaddHeuristicCallback(m, slow_heur_cb, NULL));
+    CHECK(CSIPsetCallbackBudget(m, CSIP_CALLBACKTYPE_LAZY, 0, 0.001, 1));
+    CHECK(CSIPsetCallbackBudget(m, CSIP_CALLBACKTYPE_HEURISTIC, 0, 0.001, 1));
+    mu_assert_int("Budget for missing callback accepted!",
+                  CSIPsetCallbackBudget(m, CSIP_CALLBACKTYPE_LAZY, 1, 0.001, 1),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 2.0);
+
+    CHECK(CSIPgetCallbackStats(m, CSIP_CALLBACKTYPE_LAZY, 0, &stats));
+    mu_assert("Lazy callback not called!", stats.ncalls > 0);
+    mu_assert("Overrun not counted!", stats.noverruns > 0);
+    mu_assert_int("Lazy callback not flagged!", stats.flagged, 1);
+
+    CHECK(CSIPgetCallbackStats(m, CSIP_CALLBACKTYPE_HEURISTIC, 0, &stats));
+    mu_assert("Wrong number of overruns!", stats.noverruns == stats.ncalls);
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_deterministic()
+{
+    // max x + y, x + y <= 1, binary: (1, 0) and (0, 1) tie. Scenario A fixes
+    // y = 0, scenario B fixes x = 0 and scenario C changes nothing. If C
+    // started from the solution of the scenario solved before it on the same
+    // worker, its solution would depend on the batch, so C must give the
+    // same solution after A, after B, and alone
+    int indices[] = {0, 1};
+    double objcoef[] = {1.0, 1.0};
+    double coefs[] = {1.0, 1.0};
+    int xidx[] = {0};
+    int yidx[] = {1};
+    double zero[] = {0.0};
+    double values[3][2][2];
+    CSIP_SCENARIO deltas[3] = {{0}};
+    CSIP_SCENARIO batches[3][2];
+    CSIP_SCENARIO_RESULT results[3][2] = {{{0}}};
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    CHECK(CSIPsetSenseMaximize(m));
+    CHECK(CSIPsetObj(m, 2, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 2, indices, coefs, -INFINITY, 1.0, NULL));
+    CHECK(CSIPsetDeterministic(m, 1));
+
+    deltas[0].nbounds = 1;
+    deltas[0].boundindices = yidx;
+    deltas[0].upperbounds = zero;
+    deltas[1].nbounds = 1;
+    deltas[1].boundindices = xidx;
+    deltas[1].upperbounds = zero;
+
+    // batches A, C and B, C on one worker, and C alone
+    batches[0][0] = deltas[0];
+    batches[0][1] = deltas[2];
+    batches[1][0] = deltas[1];
+    batches[1][1] = deltas[2];
+    batches[2][0] = deltas[2];
+    for (int b = 0; b < 3; b++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            results[b][i].values = values[b][i];
+        }
+    }
+    CHECK(CSIPsolveScenarios(m, 2, batches[0], 1, results[0]));
+    CHECK(CSIPsolveScenarios(m, 2, batches[1], 1, results[1]));
+    CHECK(CSIPsolveScenarios(m, 1, batches[2], 1, results[2]));
+
+    mu_assert_near("Wrong solution!", values[0][0][0], 1.0);
+    mu_assert_near("Wrong solution!", values[1][0][1], 1.0);
+    for (int b = 0; b < 2; b++)
+    {
+        mu_assert_near("Wrong objective value!", results[b][1].objvalue, 1.0);
+        mu_assert("Solution depends on batch!",
+                  memcmp(values[b][1], values[2][0], sizeof(values[2][0])) == 0);
+    }
+
+    CHECK(CSIPfreeModel(m));
+}
+
+// write metrics to a temporary file and read them back into buffer
+static void readMetrics(char *buffer, size_t size)
+{
+    FILE *file = tmpfile();
+    size_t len;
+
+    mu_assert("Can't create temporary file!", file != NULL);
+    CHECK(CSIPwriteMetrics(fileno(file)));
+    rewind(file);
+    len = fread(buffer, 1, size - 1, file);
+    buffer[len] = '\0';
+    fclose(file);
+}
+
+// value of the sample with the given name and labels, or -1 if there is none
+static long long getMetric(const char *buffer, const char *sample)
+{
+    size_t len = strlen(sample);
+    const char *line = buffer;
+    long long value = -1;
+
+    while (line != NULL && *line != '\0')
+    {
+        if (strncmp(line, sample, len) == 0 && line[len] == ' ')
+        {
+            value = atoll(&line[len + 1]);
+        }
+        line = strchr(line, '\n');
+        if (line != NULL)
+        {
+            ++line;
+        }
+    }
+    return value;
+}
+
+static void test_metrics()
+{
+    // solve knapsack of test_mip, metrics must count it
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    char before[8192];
+    char after[8192];
+    const char *eof = "# EOF\n";
+    CSIP_MODEL *m;
+
+    readMetrics(before, sizeof(before));
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+    CHECK(CSIPsolve(m));
+    CHECK(CSIPfreeModel(m));
+
+    readMetrics(after, sizeof(after));
+    mu_assert_int("Wrong number of solves!",
+                  (int)(getMetric(after, "csip_solves_started_total")
+                        - getMetric(before, "csip_solves_started_total")), 1);
+    mu_assert_int("Wrong number of optimal solves!",
+                  (int)(getMetric(after, "csip_solves_completed_total{status=\"optimal\"}")
+                        - getMetric(before, "csip_solves_completed_total{status=\"optimal\"}")),
+                  1);
+    mu_assert_int("Wrong histogram count!",
+                  (int)(getMetric(after, "csip_solve_seconds_bucket{le=\"+Inf\"}")
+                        - getMetric(before, "csip_solve_seconds_bucket{le=\"+Inf\"}")), 1);
+    mu_assert("No memory sampled!",
+              getMetric(after, "csip_model_memory_sampled_max_bytes") > 0);
+    mu_assert("Missing EOF!", strlen(after) >= strlen(eof)
+              && strcmp(&after[strlen(after) - strlen(eof)], eof) == 0);
+
+    mu_assert_int("Writing to invalid fd succeeded!", CSIPwriteMetrics(-1),
+                  CSIP_RETCODE_ERROR);
+}
+
+static void test_polish()
+{
+    // knapsack of test_mip, stopped at the first solution and then polished;
+    // the optimum is -16
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    double firstobj;
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+
+    // nothing to polish yet
+    mu_assert_int("Polished without solution!", CSIPpolish(m, 1.0),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPsetIntParam(m, "limits/solutions", 1));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_USERLIMIT);
+    firstobj = CSIPgetObjValue(m);
+
+    CHECK(CSIPpolish(m, 10.0));
+    mu_assert("Polishing made solution worse!", CSIPgetObjValue(m) <= firstobj);
+    mu_assert("Polished past the optimum!", CSIPgetObjValue(m) >= -16.0 - 1e-6);
+
+    // polishing restored the solution limit, lift it to finish the search
+    CHECK(CSIPsetIntParam(m, "limits/solutions", -1));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_OPTIMAL);
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -16.0);
+
+    // finished search is left alone
+    CHECK(CSIPpolish(m, 10.0));
+    mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), -16.0);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_polish_gap()
+{
+    // knapsack with 20 items, started from the empty knapsack and stopped on
+    // the absolute gap limit; polishing must lift that limit and search on
+    int indices[20];
+    double objcoef[20];
+    double conscoef[20];
+    double zeros[20];
+    double capacity = 0.0;
+    unsigned int seed = 1;
+    CSIP_PROGRESS before;
+    CSIP_PROGRESS after;
+    double firstobj;
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    CHECK(CSIPsetIntParam(m, "presolving/maxrounds", 0));
+    CHECK(CSIPsetIntParam(m, "separating/maxroundsroot", 0));
+    for (int i = 0; i < 20; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        conscoef[i] = 10.0 + (seed >> 16) % 90;
+        seed = seed * 1103515245u + 12345u;
+        objcoef[i] = -(conscoef[i] + (seed >> 16) % 10);
+        capacity += conscoef[i];
+        indices[i] = i;
+        zeros[i] = 0.0;
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 20, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 20, indices, conscoef, -INFINITY, capacity / 2,
+                         NULL));
+
+    CHECK(CSIPsetInitialSolution(m, zeros));
+    CHECK(CSIPsetRealParam(m, "limits/absgap", 1e6));
+    CHECK(CSIPsolve(m));
+    mu_assert_int("Wrong status!", CSIPgetStatus(m), CSIP_STATUS_USERLIMIT);
+    firstobj = CSIPgetObjValue(m);
+    CHECK(CSIPgetProgressEstimate(m, &before));
+
+    CHECK(CSIPpolish(m, 10.0));
+    CHECK(CSIPgetProgressEstimate(m, &after));
+    mu_assert("Polishing processed no nodes!", after.nnodes > before.nnodes);
+    mu_assert("Polishing made solution worse!", CSIPgetObjValue(m) <= firstobj);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_initialsol_repair()
+{
+    // like test_initialsol, but the initial solution is infeasible
+    //
+    // min 2x
+    //     x + 10y <= 20
+    //     x in [10, 100], integer, y binary
+    //
+    // closest to (23, 1) is (10, 1): no binary flips, even though x moves by
+    // 13, instead of 3 for (20, 0)
+
+    int indices[] = {0, 1};
+    double objcoef[] = {2.0};
+    double conscoef[] = {1.0, 10.0};
+    double initialsol[] = {23.0, 1.0};
+    double solution[2];
+
+    for (int repair = 0; repair <= 1; ++repair)
+    {
+        CSIP_MODEL *m;
+
+        CHECK(CSIPcreateModel(&m));
+        CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+        CHECK(CSIPsetIntParam(m, "limits/solutions", 1));
+        CHECK(CSIPsetIntParam(m, "heuristics/trivial/freq", -1));
+
+        CHECK(CSIPaddVar(m, 10.0, 100.0, CSIP_VARTYPE_INTEGER, NULL)); // x
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL)); // y
+        CHECK(CSIPsetObj(m, 1, indices, objcoef));
+        CHECK(CSIPaddLinCons(m, 2, indices, conscoef, -INFINITY, 20.0, NULL));
+        mu_assert_int("Wrong initial solution status!",
+                      CSIPgetInitialSolutionStatus(m), CSIP_INITSOL_NONE);
+
+        CHECK(CSIPsetInitialSolutionRepair(m, repair ? 10.0 : 0.0));
+        CHECK(CSIPsetInitialSolution(m, initialsol));
+        CHECK(CSIPsolve(m));
+
+        if (!repair)
+        {
+            mu_assert_int("Wrong initial solution status!",
+                          CSIPgetInitialSolutionStatus(m),
+                          CSIP_INITSOL_INFEASIBLE);
+        }
+        else
+        {
+            mu_assert_int("Wrong initial solution status!",
+                          CSIPgetInitialSolutionStatus(m),
+                          CSIP_INITSOL_REPAIRED);
+            mu_assert_near("Wrong objective value!", CSIPgetObjValue(m), 20.0);
+
+            CHECK(CSIPgetVarValues(m, solution));
+            mu_assert_near("Wrong solution!", solution[0], 10.0);
+            mu_assert_near("Wrong solution!", solution[1], 1.0);
+        }
+
+        CHECK(CSIPfreeModel(m));
+    }
+}
+
+static void test_evalgrad()
+{
+    // x0 <= 1 (linear, no gradient)
+    // f(x) = x2 * x0 + exp(x2), gradient (x2, x0 + exp(x2)) on x0, x2
+    // objective x1^2, gradient 2 x1 on x1
+
+    CSIP_MODEL *m;
+    int linindices[] = {0};
+    double lincoefs[] = {1.0};
+    CSIP_OP ops[] = {VARIDX, VARIDX, PROD, VARIDX, EXP, SUM};
+    int children[] = {2, 0, 0, 1, 2, 3, 2, 4};
+    int begin[] = {0, 1, 2, 4, 5, 6, 8};
+    CSIP_OP objops[] = {VARIDX, CONST, POW};
+    int objchildren[] = {1, 0, 0, 1};
+    int objbegin[] = {0, 1, 2, 4};
+    double objvalues[] = {2.0};
+    double points[] = {1.0, 5.0, 0.0, 2.0, 5.0, 1.0};
+    int indices[2];
+    double vals[2];
+    double grads[4];
+    int nvars;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 3; ++i)
+    {
+        CHECK(CSIPaddVar(m, -10.0, 10.0, CSIP_VARTYPE_CONTINUOUS, NULL));
+    }
+    CHECK(CSIPaddLinCons(m, 1, linindices, lincoefs, -INFINITY, 1.0, NULL));
+    CHECK(CSIPaddNonLinCons(m, 6, ops, children, begin, NULL, -INFINITY, 10.0,
+                            NULL));
+    CHECK(CSIPsetNonlinearObj(m, 3, objops, objchildren, objbegin, objvalues));
+
+    mu_assert_int("Linear constraint has gradient!",
+                  CSIPgetNonLinVars(m, 0, &nvars, NULL), CSIP_RETCODE_ERROR);
+    mu_assert_int("Linear constraint has gradient!",
+                  CSIPevalGradBatch(m, 0, 1, points, vals, grads),
+                  CSIP_RETCODE_ERROR);
+    mu_assert_int("Gradient of missing constraint!",
+                  CSIPevalGradBatch(m, 2, 1, points, vals, grads),
+                  CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPgetNonLinVars(m, 1, &nvars, indices));
+    mu_assert_int("Wrong number of variables!", nvars, 2);
+    mu_assert_int("Wrong variable!", indices[0], 0);
+    mu_assert_int("Wrong variable!", indices[1], 2);
+
+    CHECK(CSIPevalGradBatch(m, 1, 2, points, vals, grads));
+    mu_assert_near("Wrong value!", vals[0], 1.0);
+    mu_assert_near("Wrong gradient!", grads[0], 0.0);
+    mu_assert_near("Wrong gradient!", grads[1], 2.0);
+    mu_assert_near("Wrong value!", vals[1], 2.0 + exp(1.0));
+    mu_assert_near("Wrong gradient!", grads[2], 1.0);
+    mu_assert_near("Wrong gradient!", grads[3], 2.0 + exp(1.0));
+
+    CHECK(CSIPgetNonLinVars(m, -1, &nvars, indices));
+    mu_assert_int("Wrong number of variables!", nvars, 1);
+    mu_assert_int("Wrong variable!", indices[0], 1);
+    CHECK(CSIPevalGradBatch(m, -1, 1, points, vals, grads));
+    mu_assert_near("Wrong value!", vals[0], 25.0);
+    mu_assert_near("Wrong gradient!", grads[0], 10.0);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+static void test_varvaluechanges()
+{
+    // knapsack of test_mip, solution (1, 0, 0, 1, 1); with x_3 <= 0 the
+    // solution is (1, 0, 0, 0, 1)
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    double zeros[] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    int varidx[] = {3};
+    double ub[] = {0.0};
+    int changed[5];
+    double newvalues[5];
+    int nchanged;
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+
+    // no solution yet
+    mu_assert_int("Got changes without solution!",
+                  CSIPgetVarValueChanges(m, &nchanged, changed, newvalues),
+                  CSIP_RETCODE_ERROR);
+
+    // without baseline, all variables are returned
+    CHECK(CSIPsolve(m));
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 5);
+    mu_assert_near("Wrong value!", newvalues[3], 1.0);
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 0);
+
+    CHECK(CSIPchgVarUB(m, 1, varidx, ub));
+    CHECK(CSIPsolve(m));
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 1);
+    mu_assert_int("Wrong changed variable!", changed[0], 3);
+    mu_assert_near("Wrong value!", newvalues[0], 0.0);
+
+    CHECK(CSIPsetVarValueBaseline(m, zeros));
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 2);
+    mu_assert_int("Wrong changed variable!", changed[0], 0);
+    mu_assert_int("Wrong changed variable!", changed[1], 4);
+
+    // with tolerance 0.1, x_0 = 1 is no change from 0.95
+    double nearby[] = {0.95, 0.0, 0.0, 0.0, 0.0};
+    CHECK(CSIPsetVarValueTolerance(m, 0.1));
+    CHECK(CSIPsetVarValueBaseline(m, nearby));
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 1);
+    mu_assert_int("Wrong changed variable!", changed[0], 4);
+
+    // back to the feasibility tolerance
+    CHECK(CSIPsetVarValueTolerance(m, -1.0));
+    CHECK(CSIPsetVarValueBaseline(m, nearby));
+    CHECK(CSIPgetVarValueChanges(m, &nchanged, changed, newvalues));
+    mu_assert_int("Wrong number of changes!", nchanged, 2);
+    mu_assert_int("NaN tolerance accepted!",
+                  CSIPsetVarValueTolerance(m, NAN), CSIP_RETCODE_ERROR);
+
+    CHECK(CSIPfreeModel(m));
+}
+
+// executor that runs jobs right away, counting them in executordata[0] and
+// with concurrency executordata[1]
+void *inline_submit(void *executordata, CSIP_JOB job, void *arg)
+{
+    int *counts = (int *) executordata;
+
+    job(arg);
+    ++counts[0];
+    return executordata;
+}
+
+void inline_wait(void *executordata, void *handle)
+{
+}
+
+int inline_concurrency(void *executordata)
+{
+    return ((int *) executordata)[1];
+}
+
+static void test_executor()
+{
+    // scenarios of test_scenarios, without the bound change (2 is the base
+    // model), on an executor with 4 threads: first limited to 2 workers (1 job
+    // and the calling thread), then not
+    int indices[] = {0, 1, 2, 3, 4};
+    double objcoef[] = { -5.0, -3.0, -2.0, -7.0, -4.0};
+    double conscoef[] = {2.0, 8.0, 4.0, 2.0, 5.0};
+    int considx[] = {0};
+    double rhs[] = {2.0};
+    int counts[] = {0, 2};
+    CSIP_EXECUTOR executor =
+    {
+        inline_submit, inline_wait, inline_concurrency, counts
+    };
+    CSIP_EXECUTOR badexecutor = {NULL, inline_wait, NULL, NULL};
+    CSIP_SCENARIO deltas[4] = {{0}};
+    CSIP_SCENARIO_RESULT results[4] = {{0}};
+    CSIP_MODEL *m;
+
+    CHECK(CSIPcreateModel(&m));
+    CHECK(CSIPsetIntParam(m, "display/verblevel", 2));
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(CSIPaddVar(m, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL));
+    }
+    CHECK(CSIPsetObj(m, 5, indices, objcoef));
+    CHECK(CSIPaddLinCons(m, 5, indices, conscoef, -INFINITY, 10.0, NULL));
+
+    deltas[1].nsides = 1;
+    deltas[1].consindices = considx;
+    deltas[1].rhs = rhs;
+    deltas[3] = deltas[1];
+
+    mu_assert_int("Executor without submit accepted!",
+                  CSIPsetExecutor(m, &badexecutor), CSIP_RETCODE_ERROR);
+
+    // the global executor is used unless the model has one
+    CHECK(CSIPsetGlobalExecutor(&executor));
+    CHECK(CSIPsolveScenarios(m, 4, deltas, 4, results));
+    mu_assert_int("Wrong number of jobs!", counts[0], 1);
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -16.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -7.0);
+    mu_assert_near("Wrong objective value!", results[3].objvalue, -7.0);
+    CHECK(CSIPsetGlobalExecutor(NULL));
+
+    counts[0] = 0;
+    counts[1] = 0;
+    CHECK(CSIPsetExecutor(m, &executor));
+    CHECK(CSIPsolveScenarios(m, 4, deltas, 4, results));
+    mu_assert_int("Wrong number of jobs!", counts[0], 3);
+    mu_assert_near("Wrong objective value!", results[0].objvalue, -16.0);
+    mu_assert_near("Wrong objective value!", results[1].objvalue, -7.0);
+    mu_assert_near("Wrong objective value!", results[3].objvalue, -7.0);
+
+    CHECK(CSIPfreeModel(m));
+}
+
 static void test_params()
 {
     CSIP_MODEL *m;
@@ -1257,6 +2721,31 @@ int main(int argc, char **argv)
     mu_run_test(test_initialsol_partial);
     mu_run_test(test_initialsol_nlp_partial);
     mu_run_test(test_heurcb);
+    mu_run_test(test_progress);
+    mu_run_test(test_scenarios);
+    mu_run_test(test_workercpus);
+    mu_run_test(test_benders);
+    mu_run_test(test_benders_duals);
+    mu_run_test(test_replaceobj);
+    mu_run_test(test_recording);
+    mu_run_test(test_sweeprhs);
+    mu_run_test(test_quadconss);
+    mu_run_test(test_sosbatch);
+    mu_run_test(test_nonlinconss);
+    mu_run_test(test_exprtemplate);
+    mu_run_test(test_curvature);
+    mu_run_test(test_orbitope);
+    mu_run_test(test_bounddisjunction);
+    mu_run_test(test_cumulative);
+    mu_run_test(test_callbackbudget);
+    mu_run_test(test_deterministic);
+    mu_run_test(test_metrics);
+    mu_run_test(test_polish);
+    mu_run_test(test_polish_gap);
+    mu_run_test(test_initialsol_repair);
+    mu_run_test(test_evalgrad);
+    mu_run_test(test_varvaluechanges);
+    mu_run_test(test_executor);
     mu_run_test(test_params);
     mu_run_test(test_prefix);
 
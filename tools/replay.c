@@ -0,0 +1,28 @@
+// csip-replay: rebuild and solve a model from a file written by
+// CSIPstartRecording, to reproduce a solve offline.
+#include <stdio.h>
+
+#include <csip.h>
+
+int main(int argc, char **argv)
+{
+    CSIP_MODEL *model;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <recording>\n", argv[0]);
+        return 1;
+    }
+
+    if (CSIPreplayRecording(argv[1], &model) != CSIP_RETCODE_OK)
+    {
+        fprintf(stderr, "could not replay %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("status: %d\n", CSIPgetStatus(model));
+    printf("objective bound: %g\n", CSIPgetObjBound(model));
+    CSIPfreeModel(model);
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+// csip-scaling: create, build and solve many small models concurrently on
+// 1, 2, 4, ... threads and report throughput, latency and scaling, to find
+// contention in CSIP and SCIP when many models are active at once.
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <csip.h>
+
+#define NPHASES 4
+#define NITEMS 30
+#define NKNAPSACKS 2
+
+static const char *phasenames[NPHASES] = {"create", "build", "solve", "free"};
+
+// likely shared resources behind a slowdown of each phase
+static const char *phasecauses[NPHASES] =
+{
+    "malloc, plugin registration",
+    "malloc",
+    "malloc, message handler and stdio (with -v), metrics lock",
+    "malloc"
+};
+
+struct bench
+{
+    int nmodels;
+    int verbose;
+    int next;
+    pthread_mutex_t lock;
+
+    double *latency;               // per model, seconds
+    double phasetime[NPHASES];     // summed over models, seconds
+};
+
+static
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// multidimensional knapsack; the same seed gives the same model
+static
+void buildModel(CSIP_MODEL *model, unsigned int seed)
+{
+    int indices[NITEMS];
+    double coefs[NITEMS];
+    int i;
+    int k;
+
+    for (i = 0; i < NITEMS; ++i)
+    {
+        CSIPaddVar(model, 0.0, 1.0, CSIP_VARTYPE_BINARY, NULL);
+        indices[i] = i;
+    }
+    for (k = 0; k <= NKNAPSACKS; ++k)
+    {
+        double sum = 0.0;
+
+        for (i = 0; i < NITEMS; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            coefs[i] = 1.0 + (seed >> 16) % 100;
+            sum += coefs[i];
+        }
+        if (k == NKNAPSACKS)
+        {
+            for (i = 0; i < NITEMS; ++i)
+            {
+                coefs[i] = -coefs[i];
+            }
+            CSIPsetObj(model, NITEMS, indices, coefs);
+        }
+        else
+        {
+            CSIPaddLinCons(model, NITEMS, indices, coefs, -INFINITY, sum / 2,
+                           NULL);
+        }
+    }
+}
+
+static
+void *worker(void *arg)
+{
+    struct bench *bench = (struct bench *) arg;
+    double phasetime[NPHASES] = {0.0};
+    int p;
+
+    for (;;)
+    {
+        CSIP_MODEL *model;
+        double t[NPHASES + 1];
+        int m;
+
+        pthread_mutex_lock(&bench->lock);
+        m = bench->next++;
+        pthread_mutex_unlock(&bench->lock);
+        if (m >= bench->nmodels)
+        {
+            break;
+        }
+
+        t[0] = now();
+        CSIPcreateModel(&model);
+        CSIPsetIntParam(model, "display/verblevel", bench->verbose ? 4 : 0);
+        t[1] = now();
+        buildModel(model, (unsigned int) m);
+        t[2] = now();
+        CSIPsolve(model);
+        t[3] = now();
+        CSIPfreeModel(model);
+        t[4] = now();
+
+        bench->latency[m] = t[NPHASES] - t[0];
+        for (p = 0; p < NPHASES; ++p)
+        {
+            phasetime[p] += t[p + 1] - t[p];
+        }
+    }
+
+    pthread_mutex_lock(&bench->lock);
+    for (p = 0; p < NPHASES; ++p)
+    {
+        bench->phasetime[p] += phasetime[p];
+    }
+    pthread_mutex_unlock(&bench->lock);
+
+    return NULL;
+}
+
+static
+int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+// solve all models on nthreads threads, returns wall clock time
+static
+double run(struct bench *bench, int nthreads)
+{
+    pthread_t *threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+    double start;
+    int t;
+
+    bench->next = 0;
+    memset(bench->phasetime, 0, sizeof(bench->phasetime));
+
+    start = now();
+    for (t = 0; t < nthreads; ++t)
+    {
+        pthread_create(&threads[t], NULL, worker, bench);
+    }
+    for (t = 0; t < nthreads; ++t)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+
+    return now() - start;
+}
+
+int main(int argc, char **argv)
+{
+    struct bench bench;
+    double basethroughput = 0.0;
+    double basephase[NPHASES];
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxthreads = 64;
+    int nthreads;
+    int i;
+
+    bench.nmodels = 256;
+    bench.verbose = 0;
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            bench.verbose = 1;
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            bench.nmodels = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            maxthreads = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n models] [-t maxthreads] [-v]\n"
+                    "  -v  keep SCIP output on (redirect stdout to discard "
+                    "it), to measure its cost\n", argv[0]);
+            return 1;
+        }
+    }
+    if (bench.nmodels < 1 || maxthreads < 1)
+    {
+        fprintf(stderr, "need at least one model and one thread\n");
+        return 1;
+    }
+
+    bench.latency = (double *) malloc(bench.nmodels * sizeof(double));
+    pthread_mutex_init(&bench.lock, NULL);
+
+    // results go to stderr, so that SCIP output (-v) can be discarded
+    fprintf(stderr, "%d models, %ld cpus\n", bench.nmodels, ncpus);
+    fprintf(stderr, "%7s %10s %9s %9s %10s", "threads", "solves/s", "p50[ms]",
+            "p99[ms]", "efficiency");
+    for (i = 0; i < NPHASES; ++i)
+    {
+        fprintf(stderr, " %7s[ms]", phasenames[i]);
+    }
+    fprintf(stderr, "\n");
+
+    for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2)
+    {
+        double wall = run(&bench, nthreads);
+        double throughput = bench.nmodels / wall;
+        int p99 = (int) ceil(0.99 * bench.nmodels) - 1;
+
+        qsort(bench.latency, bench.nmodels, sizeof(double), compareDoubles);
+        if (nthreads == 1)
+        {
+            basethroughput = throughput;
+            for (i = 0; i < NPHASES; ++i)
+            {
+                basephase[i] = bench.phasetime[i] / bench.nmodels;
+            }
+        }
+
+        fprintf(stderr, "%7d %10.1f %9.2f %9.2f %10.2f", nthreads, throughput,
+                1e3 * bench.latency[bench.nmodels / 2],
+                1e3 * bench.latency[p99],
+                throughput / (nthreads * basethroughput));
+        for (i = 0; i < NPHASES; ++i)
+        {
+            fprintf(stderr, " %11.3f", 1e3 * bench.phasetime[i] / bench.nmodels);
+        }
+        fprintf(stderr, "\n");
+
+        // without oversubscription, a phase should take as long per model as
+        // on one thread; if it does not, threads wait for each other
+        if (nthreads > 1 && nthreads <= ncpus)
+        {
+            for (i = 0; i < NPHASES; ++i)
+            {
+                double slowdown = bench.phasetime[i] / bench.nmodels
+                                  / basephase[i];
+
+                if (slowdown > 1.5)
+                {
+                    fprintf(stderr, "        contention: %s is %.1fx slower per "
+                            "model (shared: %s)\n", phasenames[i], slowdown,
+                            phasecauses[i]);
+                }
+            }
+        }
+    }
+
+    pthread_mutex_destroy(&bench.lock);
+    free(bench.latency);
+
+    return 0;
+}